@@ -0,0 +1,125 @@
+/*
+  This file is part of KTnef.
+
+  Copyright (C) 2026 KDE e.V.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software Foundation,
+  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+*/
+
+#include "ktnefextractor.h"
+#include "ktnef_debug.h"
+
+#include <KTNEF/KTNEFAttach>
+#include <KTNEF/KTNEFMessage>
+#include <KTNEF/KTNEFParser>
+
+#include <QDir>
+#include <QFutureWatcher>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+using namespace KTnef;
+
+KTNEFExtractor::KTNEFExtractor(QObject *parent)
+    : QObject(parent)
+    , mThreadPool(new QThreadPool(this))
+{
+}
+
+KTNEFExtractor::~KTNEFExtractor()
+{
+    cancel();
+    mThreadPool->waitForDone();
+}
+
+void KTNEFExtractor::setMaxThreadCount(int count)
+{
+    mThreadPool->setMaxThreadCount(qMax(1, count));
+}
+
+void KTNEFExtractor::addFile(const QString &fileName, const QString &targetDir, const QStringList &attachmentNames)
+{
+    QString dir = targetDir;
+    if (!dir.endsWith(QLatin1Char('/'))) {
+        dir.append(QLatin1Char('/'));
+    }
+    mTasks.append({fileName, dir, attachmentNames});
+}
+
+bool KTNEFExtractor::isRunning() const
+{
+    return mRunningTasks > 0;
+}
+
+void KTNEFExtractor::start()
+{
+    mCanceled.store(0);
+    const QVector<Task> tasks = mTasks;
+    mTasks.clear();
+    if (tasks.isEmpty()) {
+        Q_EMIT finished(false);
+        return;
+    }
+    for (const Task &task : tasks) {
+        auto watcher = new QFutureWatcher<void>(this);
+        connect(watcher, &QFutureWatcherBase::finished, this, &KTNEFExtractor::slotTaskFinished);
+        watcher->setFuture(QtConcurrent::run(mThreadPool, [this, task]() {
+            extract(task);
+        }));
+        ++mRunningTasks;
+    }
+}
+
+void KTNEFExtractor::cancel()
+{
+    mCanceled.store(1);
+}
+
+void KTNEFExtractor::extract(const Task &task)
+{
+    // Runs in a worker thread, only touch the task and emit signals
+    if (mCanceled.load()) {
+        return;
+    }
+    KTNEFParser parser;
+    if (!parser.openFile(task.fileName)) {
+        qCWarning(KTNEFAPPS_LOG) << "Unable to open TNEF file" << task.fileName;
+        Q_EMIT fileOpenFailed(task.fileName);
+        return;
+    }
+    QDir().mkpath(task.targetDir);
+
+    QStringList names = task.attachmentNames;
+    if (names.isEmpty()) {
+        const QList<KTNEFAttach *> list = parser.message()->attachmentList();
+        names.reserve(list.count());
+        for (KTNEFAttach *att : list) {
+            names << att->name();
+        }
+    }
+    for (const QString &name : qAsConst(names)) {
+        if (mCanceled.load()) {
+            return;
+        }
+        if (parser.extractFileTo(name, task.targetDir)) {
+            Q_EMIT attachmentExtracted(task.fileName, name);
+        } else {
+            Q_EMIT extractionFailed(task.fileName, name);
+        }
+    }
+}
+
+void KTNEFExtractor::slotTaskFinished()
+{
+    sender()->deleteLater();
+    if (--mRunningTasks == 0) {
+        Q_EMIT finished(mCanceled.load());
+    }
+}
@@ -0,0 +1,77 @@
+/*
+  This file is part of KTnef.
+
+  Copyright (C) 2026 KDE e.V.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or
+  (at your option) any later version.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software Foundation,
+  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+*/
+
+#ifndef KTNEFEXTRACTOR_H
+#define KTNEFEXTRACTOR_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QStringList>
+#include <QVector>
+
+class QThreadPool;
+
+/**
+ * Extracts attachments of TNEF files on a pool of worker threads.
+ *
+ * Each file is parsed by its own KTNEFParser in a worker thread, so several
+ * files are extracted in parallel and the GUI thread never blocks. Signals
+ * are delivered in the thread of the receiver.
+ */
+class KTNEFExtractor : public QObject
+{
+    Q_OBJECT
+public:
+    explicit KTNEFExtractor(QObject *parent = nullptr);
+    ~KTNEFExtractor();
+
+    /**
+     * Sets the number of files extracted in parallel.
+     */
+    void setMaxThreadCount(int count);
+
+    /**
+     * Extracts the attachments named @p attachmentNames of @p fileName into
+     * @p targetDir. All attachments are extracted when the list is empty.
+     */
+    void addFile(const QString &fileName, const QString &targetDir, const QStringList &attachmentNames = QStringList());
+
+    void start();
+    void cancel();
+    bool isRunning() const;
+
+Q_SIGNALS:
+    void attachmentExtracted(const QString &fileName, const QString &attachmentName);
+    void extractionFailed(const QString &fileName, const QString &attachmentName);
+    void fileOpenFailed(const QString &fileName);
+    void finished(bool canceled);
+
+private:
+    Q_DISABLE_COPY(KTNEFExtractor)
+    struct Task {
+        QString fileName;
+        QString targetDir;
+        QStringList attachmentNames;
+    };
+    void extract(const Task &task);
+    void slotTaskFinished();
+
+    QVector<Task> mTasks;
+    QThreadPool *mThreadPool = nullptr;
+    QAtomicInt mCanceled;
+    int mRunningTasks = 0;
+};
+
+#endif // KTNEFEXTRACTOR_H
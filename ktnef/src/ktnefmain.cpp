@@ -18,6 +18,7 @@
 #include "attachpropertydialog.h"
 #include "ktnefview.h"
 #include "messagepropertydialog.h"
+#include "ktnefextractor.h"
 
 #include <KTNEF/KTNEFAttach>
 #include <KTNEF/KTNEFMessage>
@@ -52,6 +53,8 @@
 #include <QMimeDatabase>
 #include <QMimeType>
 #include <QFileDialog>
+#include <QProgressDialog>
+#include <QSharedPointer>
 #include <QStatusBar>
 
 KTNEFMain::KTNEFMain(QWidget *parent)
@@ -309,22 +312,48 @@ void KTNEFMain::extractFileTo()
 
 void KTNEFMain::extractAllFiles()
 {
-    QString dir = QFileDialog::getExistingDirectory(this, QString(), mLastDir);
+    if (mExtractor) {
+        return;
+    }
+    const QString dir = QFileDialog::getExistingDirectory(this, QString(), mLastDir);
     if (!dir.isEmpty()) {
         mLastDir = dir;
-        dir.append(QLatin1String("/"));
-        QList<KTNEFAttach *> list = mParser->message()->attachmentList();
-        QList<KTNEFAttach *>::ConstIterator it;
-        QList<KTNEFAttach *>::ConstIterator end(list.constEnd());
-        for (it = list.constBegin(); it != end; ++it) {
-            if (!mParser->extractFileTo((*it)->name(), dir)) {
-                KMessageBox::error(
+        const int total = mParser->message()->attachmentList().count();
+
+        // Extract in a worker thread, big files would block the window otherwise
+        mExtractor = new KTNEFExtractor(this);
+        mExtractor->addFile(mFilename, dir);
+
+        QProgressDialog *progress = new QProgressDialog(i18nc("@label", "Extracting attachments..."),
+                                                        i18nc("@action:button", "Cancel"), 0, total, this);
+        progress->setWindowTitle(i18nc("@title:window", "Extract All"));
+        progress->setWindowModality(Qt::WindowModal);
+        progress->setMinimumDuration(500);
+        progress->setValue(0);
+        connect(progress, &QProgressDialog::canceled, mExtractor, &KTNEFExtractor::cancel);
+
+        QSharedPointer<QStringList> failures(new QStringList);
+        connect(mExtractor, &KTNEFExtractor::attachmentExtracted, progress, [progress]() {
+            progress->setValue(progress->value() + 1);
+        });
+        connect(mExtractor, &KTNEFExtractor::extractionFailed, this, [failures](const QString &, const QString &name) {
+            failures->append(name);
+        });
+        connect(mExtractor, &KTNEFExtractor::fileOpenFailed, this, [failures](const QString &fileName) {
+            failures->append(fileName);
+        });
+        connect(mExtractor, &KTNEFExtractor::finished, this, [this, progress, failures]() {
+            progress->deleteLater();
+            mExtractor->deleteLater();
+            mExtractor = nullptr;
+            if (!failures->isEmpty()) {
+                KMessageBox::errorList(
                     this,
-                    i18nc("@info",
-                          "Unable to extract file \"%1\".", (*it)->name()));
-                return;
+                    i18nc("@info", "Unable to extract the following files:"),
+                    *failures);
             }
-        }
+        });
+        mExtractor->start();
     }
 }
 
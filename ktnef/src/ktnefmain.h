@@ -33,6 +33,7 @@ class KTNEFAttach;
 using namespace KTnef;
 
 class KTNEFView;
+class KTNEFExtractor;
 
 class KTNEFMain : public KXmlGuiWindow
 {
@@ -91,6 +92,7 @@ private:
     QString mLastDir;
     KTNEFView *mView = nullptr;
     KTNEFParser *mParser = nullptr;
+    KTNEFExtractor *mExtractor = nullptr;
     KRecentFilesAction *mOpenRecentFileAction = nullptr;
 };
 Q_DECLARE_METATYPE(KService::Ptr)
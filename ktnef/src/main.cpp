@@ -24,13 +24,75 @@
 #include <QApplication>
 #include <KDBusService>
 #include <KCrash>
+#include <QDir>
+#include <QFileInfo>
+#include <QScopedPointer>
+#include <QSet>
+#include <QThread>
+#include <QTextStream>
+
+#include "ktnefextractor.h"
+
+static bool isBatchMode(int argc, char *argv[])
+{
+    // Decided before creating the application, batch mode must work without a display
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--extract-to") == 0 || qstrncmp(argv[i], "--extract-to=", 13) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int extractFiles(const QStringList &files, const QString &targetDir, int jobs)
+{
+    KTNEFExtractor extractor;
+    extractor.setMaxThreadCount(jobs);
+    QSet<QString> usedDirs;
+    for (const QString &file : files) {
+        // Each file gets its own directory when extracting several of them,
+        // TNEF files are often all named winmail.dat
+        QString dir = targetDir;
+        if (files.count() > 1) {
+            const QString baseDir = targetDir + QLatin1Char('/') + QFileInfo(file).completeBaseName();
+            dir = baseDir;
+            for (int i = 2; usedDirs.contains(dir); ++i) {
+                dir = baseDir + QLatin1Char('_') + QString::number(i);
+            }
+            usedDirs.insert(dir);
+        }
+        extractor.addFile(QFileInfo(file).absoluteFilePath(), dir);
+    }
+
+    int errors = 0;
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    // The extraction signals come from worker threads: use the extractor as
+    // context so that the output and the error count are handled in this thread
+    QObject::connect(&extractor, &KTNEFExtractor::attachmentExtracted, &extractor, [&out](const QString &fileName, const QString &name) {
+        out << fileName << ": " << name << endl;
+    });
+    QObject::connect(&extractor, &KTNEFExtractor::extractionFailed, &extractor, [&err, &errors](const QString &fileName, const QString &name) {
+        err << i18n("%1: unable to extract \"%2\"", fileName, name) << endl;
+        ++errors;
+    });
+    QObject::connect(&extractor, &KTNEFExtractor::fileOpenFailed, &extractor, [&err, &errors](const QString &fileName) {
+        err << i18n("Unable to open file \"%1\"", fileName) << endl;
+        ++errors;
+    });
+    QObject::connect(&extractor, &KTNEFExtractor::finished, qApp, &QCoreApplication::quit, Qt::QueuedConnection);
+    extractor.start();
+    qApp->exec();
+    return errors ? 1 : 0;
+}
 
 int main(int argc, char *argv[])
 {
     QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling, true);
-    QApplication app(argc, argv);
+    const bool batchMode = isBatchMode(argc, argv);
+    QScopedPointer<QCoreApplication> app(batchMode ? new QCoreApplication(argc, argv) : new QApplication(argc, argv));
     KLocalizedString::setApplicationDomain("ktnef");
-    app.setAttribute(Qt::AA_UseHighDpiPixmaps, true);
+    QCoreApplication::setAttribute(Qt::AA_UseHighDpiPixmaps, true);
     KCrash::initialize();
     Kdelibs4ConfigMigrator migrate(QStringLiteral("ktnef"));
     migrate.setConfigFiles(QStringList() << QStringLiteral("ktnefrc"));
@@ -57,13 +119,29 @@ int main(int argc, char *argv[])
     KAboutData::setApplicationData(aboutData);
 
     QCommandLineParser parser;
-    parser.setApplicationDescription(QApplication::applicationDisplayName());
-    parser.addPositionalArgument(QStringLiteral("file"), i18n("An optional argument 'file' "), QStringLiteral("[file]"));
+    parser.setApplicationDescription(aboutData.shortDescription());
+    parser.addPositionalArgument(QStringLiteral("file"), i18n("An optional argument 'file' "), QStringLiteral("[file...]"));
+    parser.addOption(QCommandLineOption(QStringLiteral("extract-to"),
+                                        i18n("Extract all attachments of the given files into <directory> without showing a window"),
+                                        QStringLiteral("directory")));
+    parser.addOption(QCommandLineOption(QStringLiteral("jobs"),
+                                        i18n("Number of files extracted in parallel with --extract-to"),
+                                        QStringLiteral("number"), QString::number(QThread::idealThreadCount())));
 
     aboutData.setupCommandLine(&parser);
-    parser.process(app);
+    parser.process(*app);
     aboutData.processCommandLine(&parser);
 
+    if (batchMode) {
+        const QStringList files = parser.positionalArguments();
+        if (files.isEmpty()) {
+            QTextStream(stderr) << i18n("No file to extract.") << endl;
+            return 1;
+        }
+        const QString targetDir = QDir(parser.value(QStringLiteral("extract-to"))).absolutePath();
+        return extractFiles(files, targetDir, parser.value(QStringLiteral("jobs")).toInt());
+    }
+
     KDBusService service;
 
     KTNEFMain *tnef = new KTNEFMain();
@@ -74,5 +152,5 @@ int main(int argc, char *argv[])
         tnef->loadFile(args.constFirst());
     }
 
-    return app.exec();
+    return app->exec();
 }
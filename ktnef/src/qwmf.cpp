@@ -29,6 +29,7 @@
 #include <QBuffer>
 #include <QFile>
 #include <QPolygon>
+#include <QtEndian>
 
 #include "ktnef_debug.h"
 
@@ -40,20 +41,6 @@ bool qwmfDebug = false;
 
 #define QWMF_DEBUG  0
 
-class WmfCmd
-{
-public:
-    ~WmfCmd()
-    {
-        delete next;
-    }
-
-    WmfCmd *next;
-    unsigned short funcIndex;
-    long numParm;
-    short *parm;
-};
-
 class WinObjHandle
 {
 public:
@@ -132,7 +119,6 @@ void WinObjFontHandle::apply(QPainter &p)
 QWinMetaFile::QWinMetaFile()
 {
     mValid = false;
-    mFirstCmd = nullptr;
     mObjHandleTab = nullptr;
     mDpi = 1000;
 }
@@ -140,7 +126,6 @@ QWinMetaFile::QWinMetaFile()
 //-----------------------------------------------------------------------------
 QWinMetaFile::~QWinMetaFile()
 {
-    delete mFirstCmd;
     if (mObjHandleTab) {
         delete[] mObjHandleTab;
     }
@@ -177,18 +162,15 @@ bool QWinMetaFile::load(QBuffer &buffer)
     WmfMetaHeader header;
     WmfPlaceableHeader pheader;
     WORD checksum;
-    int filePos, idx, i;
-    WmfCmd *cmd, *last;
+    int filePos;
     DWORD rdSize;
     WORD rdFunc;
 
     mTextAlign = 0;
     mRotation = 0;
     mTextColor = Qt::black;
-    if (mFirstCmd) {
-        delete mFirstCmd;
-    }
-    mFirstCmd = nullptr;
+    mCmds.clear();
+    mParmArena.clear();
 
     st.setDevice(&buffer);
     st.setByteOrder(QDataStream::LittleEndian);   // Great, I love Qt !
@@ -288,43 +270,46 @@ bool QWinMetaFile::load(QBuffer &buffer)
     mValid = ((header.mtHeaderSize == 9) && (header.mtNoParameters == 0)) || mIsEnhanced || mIsPlaceable;
     if (mValid) {
         //----- Read Metafile Records
-        last = nullptr;
+        // Records are parsed straight from the buffer, their parameters are
+        // stored one after the other in mParmArena.
+        const QByteArray &data = buffer.data();
+        const uchar *ptr = reinterpret_cast<const uchar *>(data.constData()) + buffer.pos();
+        const uchar *dataEnd = reinterpret_cast<const uchar *>(data.constData()) + data.size();
+        mParmArena.reserve((dataEnd - ptr) / sizeof(WORD));
         rdFunc = -1;
-        while (!st.atEnd() && (rdFunc != 0)) {
-            st >> rdSize;
-            st >> rdFunc;
-            idx = findFunc(rdFunc);
+        while ((dataEnd - ptr >= 6) && (rdFunc != 0)) {
+            rdSize = qFromLittleEndian<qint32>(ptr);
+            rdFunc = qFromLittleEndian<qint16>(ptr + 4);
+            ptr += 6;
+            if (rdSize < 3) {
+                qCDebug(KTNEFAPPS_LOG) << "WMF : incorrect record size !";
+                return false;
+            }
             rdSize -= 3;
-
-            cmd = new WmfCmd;
-            cmd->next = nullptr;
-            if (last) {
-                last->next = cmd;
-            } else {
-                mFirstCmd = cmd;
+            if ((dataEnd - ptr) / static_cast<qint64>(sizeof(WORD)) < rdSize) {
+                qCDebug(KTNEFAPPS_LOG) << "WMF : file truncated !";
+                return false;
             }
 
-            cmd->funcIndex = idx;
-            cmd->numParm = rdSize;
-            cmd->parm = new WORD[ rdSize ];
-            last = cmd;
+            WmfCmd cmd;
+            cmd.funcIndex = findFunc(rdFunc);
+            cmd.numParm = rdSize;
+            cmd.parmOffset = mParmArena.size();
+            mCmds.append(cmd);
 
-            for (i = 0; i < rdSize && !st.atEnd(); ++i) {
-                st >> cmd->parm[ i ];
+            mParmArena.resize(cmd.parmOffset + rdSize);
+            WORD *parm = mParmArena.data() + cmd.parmOffset;
+            for (int i = 0; i < rdSize; ++i, ptr += sizeof(WORD)) {
+                parm[ i ] = qFromLittleEndian<qint16>(ptr);
             }
 
-            if (rdFunc == 0x020B) {           // SETWINDOWORG: dimensions
-                mBBox.setLeft(cmd->parm[ 1 ]);
-                mBBox.setTop(cmd->parm[ 0 ]);
-            }
-            if (rdFunc == 0x020C) {           // SETWINDOWEXT: dimensions
-                mBBox.setWidth(cmd->parm[ 1 ]);
-                mBBox.setHeight(cmd->parm[ 0 ]);
+            if (rdFunc == 0x020B && rdSize >= 2) {           // SETWINDOWORG: dimensions
+                mBBox.setLeft(parm[ 1 ]);
+                mBBox.setTop(parm[ 0 ]);
             }
-
-            if (i < rdSize) {
-                qCDebug(KTNEFAPPS_LOG) << "WMF : file truncated !";
-                return false;
+            if (rdFunc == 0x020C && rdSize >= 2) {           // SETWINDOWEXT: dimensions
+                mBBox.setWidth(parm[ 1 ]);
+                mBBox.setHeight(parm[ 0 ]);
             }
         }
         //----- Test records validities
@@ -344,7 +329,6 @@ bool QWinMetaFile::load(QBuffer &buffer)
 bool QWinMetaFile::paint(QPaintDevice *aTarget, bool absolute)
 {
     int idx, i;
-    WmfCmd *cmd;
 
     if (!mValid) {
         return false;
@@ -378,9 +362,10 @@ bool QWinMetaFile::paint(QPaintDevice *aTarget, bool absolute)
     }
     mInternalWorldMatrix.reset();
 
-    for (cmd = mFirstCmd; cmd; cmd = cmd->next) {
-        idx = cmd->funcIndex;
-        (this->*metaFuncTab[ idx ].method)(cmd->numParm, cmd->parm);
+    for (const WmfCmd &cmd : qAsConst(mCmds)) {
+        idx = cmd.funcIndex;
+        short *parm = mParmArena.data() + cmd.parmOffset;
+        (this->*metaFuncTab[ idx ].method)(cmd.numParm, parm);
 
         if (QWMF_DEBUG) {
             QString str, param;
@@ -393,8 +378,8 @@ bool QWinMetaFile::paint(QPaintDevice *aTarget, bool absolute)
             str += QLatin1String(metaFuncTab[ idx ].name);
             str += QLatin1String(" : ");
 
-            for (i = 0; i < cmd->numParm; ++i) {
-                param.setNum(cmd->parm[ i ]);
+            for (i = 0; i < cmd.numParm; ++i) {
+                param.setNum(parm[ i ]);
                 str += param;
                 str += QLatin1Char(' ');
             }
@@ -1044,18 +1029,37 @@ unsigned short QWinMetaFile::calcCheckSum(WmfPlaceableHeader *apmfh)
 }
 
 //-----------------------------------------------------------------------------
-int QWinMetaFile::findFunc(unsigned short aFunc) const
-{
-    int i;
+namespace {
+const int sMetaFuncCount = sizeof(metaFuncTab) / sizeof(metaFuncTab[ 0 ]);
 
-    for (i = 0; metaFuncTab[ i ].name; ++i) {
-        if (metaFuncTab[ i ].func == aFunc) {
-            return i;
+// The low byte of a metafile function number is unique, use it as index
+// of a table pointing into metaFuncTab.
+struct MetaFuncLookup
+{
+    MetaFuncLookup()
+    {
+        for (int i = 0; i < 256; ++i) {
+            index[ i ] = sMetaFuncCount - 1;
+        }
+        for (int i = 0; metaFuncTab[ i ].name; ++i) {
+            index[ metaFuncTab[ i ].func & 0xff ] = i;
         }
     }
 
+    unsigned char index[ 256 ];
+};
+}
+
+int QWinMetaFile::findFunc(unsigned short aFunc) const
+{
+    static const MetaFuncLookup lookup;
+    const int idx = lookup.index[ aFunc & 0xff ];
+    if (metaFuncTab[ idx ].func == aFunc) {
+        return idx;
+    }
+
     // here : unknown function
-    return i;
+    return sMetaFuncCount - 1;
 }
 
 //-----------------------------------------------------------------------------
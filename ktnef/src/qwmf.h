@@ -25,10 +25,10 @@
 #include <QColor>
 #include <QImage>
 #include <QRect>
+#include <QVector>
 
 class QBuffer;
 class QString;
-class WmfCmd;
 class WinObjHandle;
 struct WmfPlaceableHeader;
 
@@ -228,7 +228,14 @@ protected:
     int mTextAlign, mRotation;
     bool mWinding;
 
-    WmfCmd *mFirstCmd;
+    /** A metafile record, its parameters are stored in mParmArena */
+    struct WmfCmd {
+        unsigned short funcIndex;
+        int numParm;
+        int parmOffset;
+    };
+    QVector<WmfCmd> mCmds;
+    QVector<short> mParmArena;
     WinObjHandle **mObjHandleTab;
     QPolygon mPoints;
     int mDpi;
@@ -0,0 +1,99 @@
+/*
+  Copyright (c) 2026 KDE e.V.
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms of the GNU General Public License, version 2, as
+  published by the Free Software Foundation.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+
+#include "attachmentkeywordscannertest.h"
+#include "../editor/attachmentkeywordscanner.h"
+#include <QTest>
+#include <QTextCursor>
+#include <QTextDocument>
+
+AttachmentKeywordScannerTest::AttachmentKeywordScannerTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void AttachmentKeywordScannerTest::shouldMatchWholeWords_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<bool>("found");
+    QTest::newRow("empty") << QString() << false;
+    QTest::newRow("keyword") << QStringLiteral("see the attachment") << true;
+    QTest::newRow("case") << QStringLiteral("See ATTACHED file") << true;
+    QTest::newRow("prefix") << QStringLiteral("attachments are nice") << false;
+    QTest::newRow("suffix") << QStringLiteral("reattached") << false;
+    QTest::newRow("overlapping") << QStringLiteral("attach attached") << true;
+    QTest::newRow("several words") << QStringLiteral("I have enclosed a file") << true;
+    QTest::newRow("punctuation") << QStringLiteral("(attachment)") << true;
+}
+
+void AttachmentKeywordScannerTest::shouldMatchWholeWords()
+{
+    QFETCH(QString, text);
+    QFETCH(bool, found);
+    AttachmentKeywordScanner scanner;
+    scanner.setKeywords({QStringLiteral("attachment"), QStringLiteral("attached"), QStringLiteral("enclosed a")});
+    QCOMPARE(scanner.containsKeyword(text), found);
+}
+
+void AttachmentKeywordScannerTest::shouldDetectQuotedLines_data()
+{
+    QTest::addColumn<QString>("line");
+    QTest::addColumn<bool>("quoted");
+    QTest::newRow("text") << QStringLiteral("hello") << false;
+    QTest::newRow("empty") << QString() << false;
+    QTest::newRow("greater") << QStringLiteral("> hello") << true;
+    QTest::newRow("indented") << QStringLiteral("  > hello") << true;
+    QTest::newRow("pipe") << QStringLiteral("| hello") << true;
+    QTest::newRow("initials") << QStringLiteral("LM> hello") << true;
+    QTest::newRow("word then text") << QStringLiteral("hello > world") << false;
+}
+
+void AttachmentKeywordScannerTest::shouldDetectQuotedLines()
+{
+    QFETCH(QString, line);
+    QFETCH(bool, quoted);
+    QCOMPARE(AttachmentKeywordScanner::isQuotedLine(line), quoted);
+}
+
+void AttachmentKeywordScannerTest::shouldFollowDocumentChanges()
+{
+    QTextDocument document;
+    document.setPlainText(QStringLiteral("Hello\n> the attachment you sent\nBye"));
+    AttachmentKeywordScanner scanner;
+    scanner.setKeywords({QStringLiteral("attachment")});
+    scanner.setDocument(&document);
+    QVERIFY(!scanner.hasKeyword(QString()));
+    QVERIFY(scanner.hasKeyword(QStringLiteral("attachment")));
+    QVERIFY(!scanner.hasKeyword(QStringLiteral("Re: attachment")));
+
+    QTextCursor cursor(&document);
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText(QStringLiteral("\nThe attachment is here"));
+    QVERIFY(scanner.hasKeyword(QString()));
+
+    cursor.select(QTextCursor::BlockUnderCursor);
+    cursor.removeSelectedText();
+    QVERIFY(!scanner.hasKeyword(QString()));
+
+    cursor.movePosition(QTextCursor::Start);
+    cursor.insertText(QStringLiteral("attachment\n\n"));
+    QVERIFY(scanner.hasKeyword(QString()));
+}
+
+QTEST_MAIN(AttachmentKeywordScannerTest)
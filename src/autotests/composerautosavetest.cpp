@@ -0,0 +1,228 @@
+/*
+  Copyright (c) 2026 KDE e.V.
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms of the GNU General Public License, version 2, as
+  published by the Free Software Foundation.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+
+#include "composerautosavetest.h"
+#include "../editor/composerautosave.h"
+#include <KMime/Message>
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+#include <QTest>
+
+namespace {
+MessageCore::AttachmentPart::Ptr createAttachment(const QString &fileName, const QByteArray &data)
+{
+    MessageCore::AttachmentPart::Ptr part(new MessageCore::AttachmentPart);
+    part->setMimeType("application/octet-stream");
+    part->setName(fileName);
+    part->setFileName(fileName);
+    part->setEncoding(KMime::Headers::CEbase64);
+    part->setData(data);
+    return part;
+}
+
+KMime::Message::Ptr parse(const QByteArray &content)
+{
+    KMime::Message::Ptr msg(new KMime::Message);
+    msg->setContent(content);
+    msg->parse();
+    return msg;
+}
+
+KMime::Message::Ptr createMessage()
+{
+    return parse("From: foo@kde.org\nSubject: test\nMIME-Version: 1.0\n"
+                 "Content-Type: text/plain; charset=\"utf-8\"\nContent-Transfer-Encoding: 8bit\n\nHello\n");
+}
+
+QStringList partFiles(const QString &fileName)
+{
+    return QDir(ComposerAutoSave::autoSaveDirectory() + QLatin1String("parts"))
+           .entryList(QStringList() << (fileName + QLatin1String("-*")), QDir::Files);
+}
+
+QByteArray readFile(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+}
+
+ComposerAutoSaveTest::ComposerAutoSaveTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void ComposerAutoSaveTest::initTestCase()
+{
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void ComposerAutoSaveTest::init()
+{
+    QDir(ComposerAutoSave::autoSaveDirectory()).removeRecursively();
+}
+
+void ComposerAutoSaveTest::shouldReturnMessageWithoutParts()
+{
+    const QByteArray message = "From: foo@kde.org\nSubject: test\nContent-Type: text/plain\n\nHello\n";
+    QCOMPARE(ComposerAutoSave::assemble(message, {}), message);
+}
+
+void ComposerAutoSaveTest::shouldAppendStoredParts()
+{
+    const QByteArray message = "From: foo@kde.org\nSubject: test\nMIME-Version: 1.0\n"
+                               "Content-Type: text/plain; charset=\"utf-8\"\nContent-Transfer-Encoding: 8bit\n\nHello\n";
+    const QByteArray data("\x00\x01\x02 attachment data", 19);
+    const QByteArray part = ComposerAutoSave::encodeAttachment(createAttachment(QStringLiteral("data.bin"), data));
+
+    const KMime::Message::Ptr msg = parse(ComposerAutoSave::assemble(message, {part}));
+    QCOMPARE(msg->subject()->asUnicodeString(), QStringLiteral("test"));
+    QCOMPARE(msg->contentType()->mimeType(), QByteArrayLiteral("multipart/mixed"));
+    QCOMPARE(msg->contents().count(), 2);
+
+    KMime::Content *text = msg->contents().at(0);
+    QCOMPARE(text->contentType()->mimeType(), QByteArrayLiteral("text/plain"));
+    QCOMPARE(text->decodedText(false, true), QStringLiteral("Hello"));
+
+    KMime::Content *attachment = msg->contents().at(1);
+    QCOMPARE(attachment->contentDisposition()->filename(), QStringLiteral("data.bin"));
+    QCOMPARE(attachment->decodedContent(), data);
+}
+
+void ComposerAutoSaveTest::shouldKeepMultipartBody()
+{
+    const QByteArray message = "From: foo@kde.org\nSubject: test\n"
+                               "Content-Type: multipart/alternative;\n boundary=\"inner\"\n\n"
+                               "--inner\nContent-Type: text/plain\n\nHello\n"
+                               "--inner\nContent-Type: text/html\n\n<b>Hello</b>\n"
+                               "--inner--\n";
+    const QByteArray part = ComposerAutoSave::encodeAttachment(createAttachment(QStringLiteral("a.bin"), "abc"));
+
+    const KMime::Message::Ptr msg = parse(ComposerAutoSave::assemble(message, {part, part}));
+    QCOMPARE(msg->contentType()->mimeType(), QByteArrayLiteral("multipart/mixed"));
+    QCOMPARE(msg->contents().count(), 3);
+    KMime::Content *alternative = msg->contents().at(0);
+    QCOMPARE(alternative->contentType()->mimeType(), QByteArrayLiteral("multipart/alternative"));
+    QCOMPARE(alternative->contents().count(), 2);
+    QCOMPARE(msg->contents().at(2)->decodedContent(), QByteArrayLiteral("abc"));
+}
+
+void ComposerAutoSaveTest::shouldRestoreSavedMessage()
+{
+    const QByteArray data("\x00\x01\x02 attachment data", 19);
+    ComposerAutoSave autoSave;
+    autoSave.setFileName(QStringLiteral("restore"));
+    QVERIFY(autoSave.save(createMessage(), {createAttachment(QStringLiteral("data.bin"), data)}));
+    QCOMPARE(partFiles(QStringLiteral("restore")).count(), 1);
+
+    const QString filePath = ComposerAutoSave::autoSaveDirectory() + QLatin1String("restore");
+    int missingParts = -1;
+    const KMime::Message::Ptr msg = parse(ComposerAutoSave::restore(filePath, readFile(filePath), &missingParts));
+    QCOMPARE(missingParts, 0);
+    QVERIFY(!msg->headerByType("X-KMail-AutoSave-Parts"));
+    QCOMPARE(msg->subject()->asUnicodeString(), QStringLiteral("test"));
+    QCOMPARE(msg->contents().count(), 2);
+    QCOMPARE(msg->contents().at(0)->decodedText(false, true), QStringLiteral("Hello"));
+    QCOMPARE(msg->contents().at(1)->contentDisposition()->filename(), QStringLiteral("data.bin"));
+    QCOMPARE(msg->contents().at(1)->decodedContent(), data);
+}
+
+void ComposerAutoSaveTest::shouldReuseStoredParts()
+{
+    const MessageCore::AttachmentPart::Ptr part = createAttachment(QStringLiteral("a.bin"), "abc");
+    ComposerAutoSave autoSave;
+    autoSave.setFileName(QStringLiteral("reuse"));
+    QVERIFY(autoSave.save(createMessage(), {part}));
+    const QStringList files = partFiles(QStringLiteral("reuse"));
+    QCOMPARE(files.count(), 1);
+
+    // An unchanged attachment is not written again
+    const QString partFile = ComposerAutoSave::autoSaveDirectory() + QLatin1String("parts/") + files.first();
+    QFile file(partFile);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("stored");
+    file.close();
+    QVERIFY(autoSave.save(createMessage(), {part}));
+    QCOMPARE(partFiles(QStringLiteral("reuse")), files);
+    QCOMPARE(readFile(partFile), QByteArrayLiteral("stored"));
+
+    // A modified one is
+    part->setData("abcd");
+    QVERIFY(autoSave.save(createMessage(), {part}));
+    QCOMPARE(partFiles(QStringLiteral("reuse")).count(), 1);
+    QVERIFY(partFiles(QStringLiteral("reuse")) != files);
+}
+
+void ComposerAutoSaveTest::shouldRemoveStaleParts()
+{
+    const MessageCore::AttachmentPart::Ptr first = createAttachment(QStringLiteral("a.bin"), "abc");
+    const MessageCore::AttachmentPart::Ptr second = createAttachment(QStringLiteral("b.bin"), "def");
+    ComposerAutoSave autoSave;
+    autoSave.setFileName(QStringLiteral("prune"));
+    QVERIFY(autoSave.save(createMessage(), {first, second}));
+    QCOMPARE(partFiles(QStringLiteral("prune")).count(), 2);
+
+    QVERIFY(autoSave.save(createMessage(), {first}));
+    QCOMPARE(partFiles(QStringLiteral("prune")).count(), 1);
+
+    QVERIFY(autoSave.save(createMessage(), {}));
+    QVERIFY(partFiles(QStringLiteral("prune")).isEmpty());
+
+    autoSave.cleanup();
+    QVERIFY(!QFile::exists(ComposerAutoSave::autoSaveDirectory() + QLatin1String("prune")));
+}
+
+void ComposerAutoSaveTest::shouldSaveAfterFileWasRemoved()
+{
+    // The composer removes its full autosave file, which has the same name
+    // after a recovery, before writing the incremental one
+    ComposerAutoSave autoSave;
+    autoSave.setFileName(QStringLiteral("recovered"));
+    QVERIFY(autoSave.save(createMessage(), {createAttachment(QStringLiteral("a.bin"), "abc")}));
+    const QString filePath = ComposerAutoSave::autoSaveDirectory() + QLatin1String("recovered");
+    QVERIFY(QFile::remove(filePath));
+
+    QVERIFY(autoSave.save(createMessage(), {createAttachment(QStringLiteral("a.bin"), "abc")}));
+    QVERIFY(QFile::exists(filePath));
+    int missingParts = -1;
+    const KMime::Message::Ptr msg = parse(ComposerAutoSave::restore(filePath, readFile(filePath), &missingParts));
+    QCOMPARE(missingParts, 0);
+    QCOMPARE(msg->contents().count(), 2);
+    QCOMPARE(msg->contents().at(1)->decodedContent(), QByteArrayLiteral("abc"));
+}
+
+void ComposerAutoSaveTest::shouldReportMissingParts()
+{
+    ComposerAutoSave autoSave;
+    autoSave.setFileName(QStringLiteral("missing"));
+    QVERIFY(autoSave.save(createMessage(), {createAttachment(QStringLiteral("a.bin"), "abc")}));
+    autoSave.removeParts();
+
+    const QString filePath = ComposerAutoSave::autoSaveDirectory() + QLatin1String("missing");
+    int missingParts = 0;
+    const KMime::Message::Ptr msg = parse(ComposerAutoSave::restore(filePath, readFile(filePath), &missingParts));
+    QCOMPARE(missingParts, 1);
+    QCOMPARE(msg->subject()->asUnicodeString(), QStringLiteral("test"));
+}
+
+QTEST_GUILESS_MAIN(ComposerAutoSaveTest)
@@ -0,0 +1,65 @@
+/*
+  Copyright (c) 2026 KDE e.V.
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms of the GNU General Public License, version 2, as
+  published by the Free Software Foundation.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "forwardattachedmessagesjobtest.h"
+#include "../job/forwardattachedmessagesjob.h"
+#include <KMime/Content>
+#include <QTest>
+
+ForwardAttachedMessagesJobTest::ForwardAttachedMessagesJobTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+static QByteArray forwardedPart(const QByteArray &subject)
+{
+    KMime::Content part;
+    part.contentType()->setMimeType("message/rfc822");
+    part.setBody("From: foo@kde.org\nSubject: " + subject + "\n\nbody\n");
+    part.assemble();
+    return part.encodedContent();
+}
+
+void ForwardAttachedMessagesJobTest::shouldCreateDigest()
+{
+    const QByteArray boundary = "digestboundary";
+    QByteArray body;
+    ForwardAttachedMessagesJob::appendDigestPart(body, boundary, forwardedPart("first"));
+    ForwardAttachedMessagesJob::appendDigestPart(body, boundary, forwardedPart("second"));
+
+    QScopedPointer<KMime::Content> digest(ForwardAttachedMessagesJob::createDigest(body, boundary, 2));
+    QCOMPARE(digest->contentType()->mimeType(), QByteArray("multipart/digest"));
+    QCOMPARE(digest->contentType()->boundary(), boundary);
+    QCOMPARE(digest->contentDisposition()->filename(), QStringLiteral("digest"));
+
+    const auto contents = digest->contents();
+    QCOMPARE(contents.count(), 2);
+    QCOMPARE(contents.at(0)->contentType()->mimeType(), QByteArray("message/rfc822"));
+    QVERIFY(contents.at(0)->bodyIsMessage());
+    QCOMPARE(contents.at(0)->bodyAsMessage()->subject()->asUnicodeString(), QStringLiteral("first"));
+    QCOMPARE(contents.at(1)->bodyAsMessage()->subject()->asUnicodeString(), QStringLiteral("second"));
+}
+
+void ForwardAttachedMessagesJobTest::shouldCreateEmptyDigest()
+{
+    QScopedPointer<KMime::Content> digest(ForwardAttachedMessagesJob::createDigest(QByteArray(), "digestboundary", 0));
+    QCOMPARE(digest->contentType()->mimeType(), QByteArray("multipart/digest"));
+    QVERIFY(digest->contents().isEmpty());
+}
+
+QTEST_MAIN(ForwardAttachedMessagesJobTest)
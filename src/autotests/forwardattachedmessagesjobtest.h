@@ -0,0 +1,36 @@
+/*
+  Copyright (c) 2026 KDE e.V.
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms of the GNU General Public License, version 2, as
+  published by the Free Software Foundation.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#ifndef FORWARDATTACHEDMESSAGESJOBTEST_H
+#define FORWARDATTACHEDMESSAGESJOBTEST_H
+
+#include <QObject>
+
+class ForwardAttachedMessagesJobTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ForwardAttachedMessagesJobTest(QObject *parent = nullptr);
+    ~ForwardAttachedMessagesJobTest() = default;
+
+private Q_SLOTS:
+    void shouldCreateDigest();
+    void shouldCreateEmptyDigest();
+};
+
+#endif // FORWARDATTACHEDMESSAGESJOBTEST_H
@@ -0,0 +1,49 @@
+/*
+  Copyright (c) 2026 KDE e.V.
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms of the GNU General Public License, version 2, as
+  published by the Free Software Foundation.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "printmessagesjobtest.h"
+#include "../job/printmessagesjob.h"
+#include <QTest>
+
+PrintMessagesJobTest::PrintMessagesJobTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void PrintMessagesJobTest::shouldKeepMessagesInOrder()
+{
+    QVector<KMime::Message::Ptr> messages;
+    for (int i = 0; i < 3; ++i) {
+        KMime::Message::Ptr msg(new KMime::Message);
+        msg->setContent("From: foo@kde.org\nSubject: message " + QByteArray::number(i) + "\n\nbody\n");
+        msg->parse();
+        messages << msg;
+    }
+
+    const KMime::Message::Ptr printMsg = PrintMessagesJob::createPrintMessage(messages);
+    QCOMPARE(printMsg->contentType()->mimeType(), QByteArray("multipart/mixed"));
+    const auto contents = printMsg->contents();
+    QCOMPARE(contents.count(), 3);
+    for (int i = 0; i < 3; ++i) {
+        QCOMPARE(contents.at(i)->contentType()->mimeType(), QByteArray("message/rfc822"));
+        QVERIFY(contents.at(i)->bodyIsMessage());
+        QCOMPARE(contents.at(i)->bodyAsMessage()->subject()->asUnicodeString(), QStringLiteral("message %1").arg(i));
+    }
+}
+
+QTEST_MAIN(PrintMessagesJobTest)
@@ -0,0 +1,64 @@
+/*
+  Copyright (c) 2026 KDE e.V.
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms of the GNU General Public License, version 2, as
+  published by the Free Software Foundation.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "removeduplicatemessagesjobtest.h"
+#include "../job/removeduplicatemessagesjob.h"
+#include <QTest>
+
+namespace {
+KMime::Message::Ptr createMessage(const QByteArray &content)
+{
+    KMime::Message::Ptr msg(new KMime::Message);
+    msg->setContent(content);
+    msg->parse();
+    return msg;
+}
+}
+
+RemoveDuplicateMessagesJobTest::RemoveDuplicateMessagesJobTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void RemoveDuplicateMessagesJobTest::shouldGroupMessagesWithSameEnvelope()
+{
+    // An additional Received header must not prevent finding the duplicate
+    const KMime::Message::Ptr msg1 = createMessage("From: foo@kde.org\nSubject: test\nDate: Tue, 01 Oct 2019 10:11:12 +0000\nMessage-ID: <1@kde.org>\n\nbody\n");
+    const KMime::Message::Ptr msg2 = createMessage("Received: from localhost\nFrom: foo@kde.org\nSubject: test\nDate: Tue, 01 Oct 2019 10:11:12 +0000\nMessage-ID: <1@kde.org>\n\nbody\n");
+    QCOMPARE(RemoveDuplicateMessagesJob::candidateKey(msg1), RemoveDuplicateMessagesJob::candidateKey(msg2));
+}
+
+void RemoveDuplicateMessagesJobTest::shouldSeparateMessagesWithDifferentEnvelope()
+{
+    const KMime::Message::Ptr msg1 = createMessage("From: foo@kde.org\nSubject: test\nMessage-ID: <1@kde.org>\n\nbody\n");
+    const KMime::Message::Ptr msg2 = createMessage("From: foo@kde.org\nSubject: test\nMessage-ID: <2@kde.org>\n\nbody\n");
+    const KMime::Message::Ptr msg3 = createMessage("From: foo@kde.org\nSubject: test2\nMessage-ID: <1@kde.org>\n\nbody\n");
+    QVERIFY(RemoveDuplicateMessagesJob::candidateKey(msg1) != RemoveDuplicateMessagesJob::candidateKey(msg2));
+    QVERIFY(RemoveDuplicateMessagesJob::candidateKey(msg1) != RemoveDuplicateMessagesJob::candidateKey(msg3));
+}
+
+void RemoveDuplicateMessagesJobTest::shouldCompareBodies()
+{
+    const KMime::Message::Ptr msg1 = createMessage("Subject: test\nMessage-ID: <1@kde.org>\n\nbody\n");
+    const KMime::Message::Ptr msg2 = createMessage("Subject: other\nMessage-ID: <1@kde.org>\n\nbody\n");
+    const KMime::Message::Ptr msg3 = createMessage("Subject: test\nMessage-ID: <1@kde.org>\n\nanother body\n");
+    QCOMPARE(RemoveDuplicateMessagesJob::contentDigest(msg1), RemoveDuplicateMessagesJob::contentDigest(msg2));
+    QVERIFY(RemoveDuplicateMessagesJob::contentDigest(msg1) != RemoveDuplicateMessagesJob::contentDigest(msg3));
+}
+
+QTEST_MAIN(RemoveDuplicateMessagesJobTest)
@@ -0,0 +1,68 @@
+/*
+  Copyright (c) 2026 KDE e.V.
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms of the GNU General Public License, version 2, as
+  published by the Free Software Foundation.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#include "savemessagesinmboxjobtest.h"
+#include "../job/savemessagesinmboxjob.h"
+#include <QTest>
+
+SaveMessagesInMboxJobTest::SaveMessagesInMboxJobTest(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void SaveMessagesInMboxJobTest::shouldEscapeFromLines_data()
+{
+    QTest::addColumn<QByteArray>("input");
+    QTest::addColumn<QByteArray>("output");
+    QTest::newRow("empty") << QByteArray() << QByteArray();
+    QTest::newRow("nofrom") << QByteArray("foo\nbar\n") << QByteArray("foo\nbar\n");
+    QTest::newRow("from") << QByteArray("foo\nFrom me\nbar\n") << QByteArray("foo\n>From me\nbar\n");
+    QTest::newRow("firstline") << QByteArray("From me\n") << QByteArray(">From me\n");
+    QTest::newRow("quotedfrom") << QByteArray("a\n>>From me\n") << QByteArray("a\n>>>From me\n");
+    QTest::newRow("notatstart") << QByteArray("a From me\n") << QByteArray("a From me\n");
+    QTest::newRow("nospace") << QByteArray("Fromage\n") << QByteArray("Fromage\n");
+    QTest::newRow("lastlinewithoutnewline") << QByteArray("a\nFrom me") << QByteArray("a\n>From me");
+}
+
+void SaveMessagesInMboxJobTest::shouldEscapeFromLines()
+{
+    QFETCH(QByteArray, input);
+    QFETCH(QByteArray, output);
+    QCOMPARE(SaveMessagesInMboxJob::escapeFrom(input), output);
+}
+
+void SaveMessagesInMboxJobTest::shouldCreateMessageSeparator()
+{
+    KMime::Message::Ptr msg(new KMime::Message);
+    msg->setContent("From: Foo <foo@kde.org>\nDate: Tue, 01 Oct 2019 10:11:12 +0000\nSubject: test\n\nbody\n");
+    msg->parse();
+    const QByteArray separator = SaveMessagesInMboxJob::mboxMessageSeparator(msg);
+    QVERIFY(separator.startsWith("From foo@kde.org "));
+    QVERIFY(separator.contains("2019"));
+    QVERIFY(separator.endsWith('\n'));
+}
+
+void SaveMessagesInMboxJobTest::shouldCreateMessageSeparatorWithoutFrom()
+{
+    KMime::Message::Ptr msg(new KMime::Message);
+    msg->setContent("Subject: test\n\nbody\n");
+    msg->parse();
+    QVERIFY(SaveMessagesInMboxJob::mboxMessageSeparator(msg).startsWith("From unknown@unknown.invalid "));
+}
+
+QTEST_MAIN(SaveMessagesInMboxJobTest)
@@ -0,0 +1,38 @@
+/*
+  Copyright (c) 2026 KDE e.V.
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms of the GNU General Public License, version 2, as
+  published by the Free Software Foundation.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License along
+  with this program; if not, write to the Free Software Foundation, Inc.,
+  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+#ifndef SAVEMESSAGESINMBOXJOBTEST_H
+#define SAVEMESSAGESINMBOXJOBTEST_H
+
+#include <QObject>
+
+class SaveMessagesInMboxJobTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SaveMessagesInMboxJobTest(QObject *parent = nullptr);
+    ~SaveMessagesInMboxJobTest() = default;
+
+private Q_SLOTS:
+    void shouldEscapeFromLines_data();
+    void shouldEscapeFromLines();
+    void shouldCreateMessageSeparator();
+    void shouldCreateMessageSeparatorWithoutFrom();
+};
+
+#endif // SAVEMESSAGESINMBOXJOBTEST_H
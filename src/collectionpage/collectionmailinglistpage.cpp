@@ -42,6 +42,8 @@
 #include <KSqueezedTextLabel>
 #include "kmail_debug.h"
 
+#include <algorithm>
+
 using namespace MailCommon;
 
 CollectionMailingListPage::CollectionMailingListPage(QWidget *parent)
@@ -189,10 +191,13 @@ void CollectionMailingListPage::slotDetectMailingList()
 
     // next try the 5 most recently added messages
     if (!(mMailingList.features() & MailingList::Post)) {
-        //FIXME not load all folder
+        // Only fetch the ids of the items, the headers are fetched for the
+        // most recent ones only
         Akonadi::ItemFetchJob *job = new Akonadi::ItemFetchJob(mCurrentCollection, this);
-        job->fetchScope().fetchPayloadPart(Akonadi::MessagePart::Header);
-        connect(job, &Akonadi::ItemFetchJob::result, this, &CollectionMailingListPage::slotFetchDone);
+        job->fetchScope().setFetchModificationTime(false);
+        job->fetchScope().setFetchRemoteIdentification(false);
+        job->fetchScope().setFetchGid(false);
+        connect(job, &Akonadi::ItemFetchJob::result, this, &CollectionMailingListPage::slotItemIdsFetched);
         //Don't allow to reactive it
         mDetectButton->setEnabled(false);
     } else {
@@ -201,28 +206,28 @@ void CollectionMailingListPage::slotDetectMailingList()
     }
 }
 
-void CollectionMailingListPage::slotFetchDone(KJob *job)
+void CollectionMailingListPage::slotItemIdsFetched(KJob *job)
 {
-    mDetectButton->setEnabled(true);
     if (MailCommon::Util::showJobErrorMessage(job)) {
+        mDetectButton->setEnabled(true);
         return;
     }
     Akonadi::ItemFetchJob *fjob = qobject_cast<Akonadi::ItemFetchJob *>(job);
     Q_ASSERT(fjob);
     Akonadi::Item::List items = fjob->items();
-    const int maxchecks = 5;
-    int num = items.size();
-    for (int i = --num; (i > num - maxchecks) && (i >= 0); --i) {
-        Akonadi::Item item = items[i];
-        if (item.hasPayload<KMime::Message::Ptr>()) {
-            KMime::Message::Ptr message = item.payload<KMime::Message::Ptr>();
-            mMailingList = MessageCore::MailingList::detect(message);
-            if (mMailingList.features() & MailingList::Post) {
-                break;
-            }
-        }
-    }
-    if (!(mMailingList.features() & MailingList::Post)) {
+    const int maxchecks = qMin(5, items.count());
+    std::partial_sort(items.begin(), items.begin() + maxchecks, items.end(),
+                      [](const Akonadi::Item &lhs, const Akonadi::Item &rhs) {
+        return lhs.id() > rhs.id();
+    });
+    mItemsToCheck = items.mid(0, maxchecks);
+    fetchNextItem();
+}
+
+void CollectionMailingListPage::fetchNextItem()
+{
+    if (mItemsToCheck.isEmpty()) {
+        mDetectButton->setEnabled(true);
         if (mMailingList.features() == MailingList::None) {
             KMessageBox::error(this,
                                i18n("KMail was unable to detect any mailing list in this folder."));
@@ -231,10 +236,36 @@ void CollectionMailingListPage::slotFetchDone(KJob *job)
                                i18n("KMail was unable to fully detect a mailing list in this folder. "
                                     "Please fill in the addresses by hand."));
         }
-    } else {
-        mMLId->setText((mMailingList.id().isEmpty() ? i18n("Not available.") : mMailingList.id()));
-        fillEditBox();
+        return;
+    }
+    Akonadi::ItemFetchJob *job = new Akonadi::ItemFetchJob(mItemsToCheck.takeFirst(), this);
+    job->fetchScope().fetchPayloadPart(Akonadi::MessagePart::Header);
+    connect(job, &Akonadi::ItemFetchJob::result, this, &CollectionMailingListPage::slotFetchDone);
+}
+
+void CollectionMailingListPage::slotFetchDone(KJob *job)
+{
+    if (MailCommon::Util::showJobErrorMessage(job)) {
+        mItemsToCheck.clear();
+        mDetectButton->setEnabled(true);
+        return;
+    }
+    Akonadi::ItemFetchJob *fjob = qobject_cast<Akonadi::ItemFetchJob *>(job);
+    Q_ASSERT(fjob);
+    const Akonadi::Item::List items = fjob->items();
+    if (!items.isEmpty() && items.constFirst().hasPayload<KMime::Message::Ptr>()) {
+        KMime::Message::Ptr message = items.constFirst().payload<KMime::Message::Ptr>();
+        mMailingList = MessageCore::MailingList::detect(message);
+        if (mMailingList.features() & MailingList::Post) {
+            // Found it, don't look at older messages
+            mItemsToCheck.clear();
+            mDetectButton->setEnabled(true);
+            mMLId->setText((mMailingList.id().isEmpty() ? i18n("Not available.") : mMailingList.id()));
+            fillEditBox();
+            return;
+        }
     }
+    fetchNextItem();
 }
 
 //----------------------------------------------------------------------------
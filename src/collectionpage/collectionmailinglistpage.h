@@ -26,6 +26,7 @@
 
 #include <AkonadiWidgets/collectionpropertiespage.h>
 #include <AkonadiCore/collection.h>
+#include <AkonadiCore/item.h>
 
 class QCheckBox;
 class QPushButton;
@@ -50,6 +51,8 @@ public:
     bool canHandle(const Akonadi::Collection &col) const override;
 
 private:
+    void slotItemIdsFetched(KJob *job);
+    void fetchNextItem();
     void slotFetchDone(KJob *job);
     void init(const Akonadi::Collection &);
     /*
@@ -65,6 +68,7 @@ private:
     void fillEditBox();
 
     Akonadi::Collection mCurrentCollection;
+    Akonadi::Item::List mItemsToCheck;
     QSharedPointer<MailCommon::FolderSettings> mFolder;
 
     MailingList mMailingList;
@@ -0,0 +1,221 @@
+/*
+   Copyright (C) 2026 KDE e.V.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "attachmentkeywordscanner.h"
+
+#include <MessageCore/MessageCoreSettings>
+#include <QQueue>
+#include <QTextBlock>
+#include <QTextDocument>
+
+namespace {
+inline bool isWordCharacter(const QString &text, int pos)
+{
+    if (pos < 0 || pos >= text.length()) {
+        return false;
+    }
+    const QChar c = text.at(pos);
+    return c.isLetterOrNumber() || c.isMark() || c == QLatin1Char('_');
+}
+
+// Same as "\b" in the regular expression used by MessageComposer
+inline bool isWordBoundary(const QString &text, int pos)
+{
+    return isWordCharacter(text, pos - 1) != isWordCharacter(text, pos);
+}
+}
+
+AttachmentKeywordScanner::AttachmentKeywordScanner(QObject *parent)
+    : QObject(parent)
+{
+    const QStringList prefixes = MessageCore::MessageCoreSettings::self()->replyPrefixes()
+                                 + MessageCore::MessageCoreSettings::self()->forwardPrefixes();
+    if (!prefixes.isEmpty()) {
+        mReplyForwardPrefix = QRegularExpression(QLatin1String("^\\s*(?:") + prefixes.join(QLatin1Char('|')) + QLatin1Char(')'),
+                                                 QRegularExpression::CaseInsensitiveOption);
+    }
+    mNodes.resize(1);
+}
+
+AttachmentKeywordScanner::~AttachmentKeywordScanner()
+{
+}
+
+void AttachmentKeywordScanner::setKeywords(const QStringList &keywords)
+{
+    if (keywords == mKeywords && mNodes.size() > 1) {
+        return;
+    }
+    mKeywords = keywords;
+    mNodes.clear();
+    mNodes.resize(1);
+
+    for (const QString &keyword : keywords) {
+        if (keyword.isEmpty()) {
+            continue;
+        }
+        int state = 0;
+        for (const QChar c : keyword) {
+            const ushort key = c.toCaseFolded().unicode();
+            int next = mNodes.at(state).next.value(key, -1);
+            if (next < 0) {
+                next = mNodes.size();
+                mNodes[state].next.insert(key, next);
+                mNodes.append(Node());
+            }
+            state = next;
+        }
+        mNodes[state].keywordLengths.append(keyword.length());
+    }
+
+    // Breadth first, so that the failure link of a node's parent is always known
+    QQueue<int> queue;
+    for (auto it = mNodes.at(0).next.cbegin(), end = mNodes.at(0).next.cend(); it != end; ++it) {
+        queue.enqueue(it.value());
+    }
+    while (!queue.isEmpty()) {
+        const int state = queue.dequeue();
+        const QHash<ushort, int> children = mNodes.at(state).next;
+        for (auto it = children.cbegin(), end = children.cend(); it != end; ++it) {
+            int fail = mNodes.at(state).fail;
+            while (fail > 0 && !mNodes.at(fail).next.contains(it.key())) {
+                fail = mNodes.at(fail).fail;
+            }
+            const int child = it.value();
+            const int target = mNodes.at(fail).next.value(it.key(), 0);
+            mNodes[child].fail = (target == child) ? 0 : target;
+            mNodes[child].keywordLengths += mNodes.at(mNodes.at(child).fail).keywordLengths;
+            queue.enqueue(child);
+        }
+    }
+
+    resetBlockStates();
+}
+
+void AttachmentKeywordScanner::setDocument(QTextDocument *document)
+{
+    if (mDocument) {
+        disconnect(mDocument.data(), &QTextDocument::contentsChange, this, &AttachmentKeywordScanner::slotContentsChange);
+    }
+    mDocument = document;
+    if (mDocument) {
+        connect(mDocument.data(), &QTextDocument::contentsChange, this, &AttachmentKeywordScanner::slotContentsChange);
+    }
+    resetBlockStates();
+}
+
+void AttachmentKeywordScanner::resetBlockStates()
+{
+    mBlockStates.fill(Unknown, mDocument ? mDocument->blockCount() : 0);
+}
+
+void AttachmentKeywordScanner::slotContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+    // Blocks between the start of the change and the end of the inserted
+    // text are new or edited, every other block keeps its cached state
+    const int blockCount = mDocument->blockCount();
+    const int first = mDocument->findBlock(position).blockNumber();
+    const QTextBlock lastBlock = mDocument->findBlock(position + charsAdded);
+    const int last = lastBlock.isValid() ? lastBlock.blockNumber() : blockCount - 1;
+    const int oldLast = last - (blockCount - mBlockStates.size());
+    if (first < 0 || last < first || oldLast < first || oldLast >= mBlockStates.size()) {
+        resetBlockStates();
+        return;
+    }
+    mBlockStates.remove(first, oldLast - first + 1);
+    mBlockStates.insert(first, last - first + 1, Unknown);
+}
+
+bool AttachmentKeywordScanner::hasKeyword(const QString &subject)
+{
+    if (mNodes.size() <= 1) {
+        return false;
+    }
+
+    if (!subject.isEmpty()) {
+        const bool isReplyOrForward = !mReplyForwardPrefix.pattern().isEmpty() && mReplyForwardPrefix.match(subject).hasMatch();
+        if (!isReplyOrForward && containsKeyword(subject)) {
+            return true;
+        }
+    }
+
+    if (!mDocument) {
+        return false;
+    }
+    if (mBlockStates.size() != mDocument->blockCount()) {
+        resetBlockStates();
+    }
+
+    QTextBlock block;
+    for (int i = 0, total = mBlockStates.size(); i < total; ++i) {
+        if (mBlockStates.at(i) == Unknown) {
+            if (!block.isValid() || block.blockNumber() != i) {
+                block = mDocument->findBlockByNumber(i);
+            }
+            const QString text = block.text();
+            mBlockStates[i] = (!isQuotedLine(text) && containsKeyword(text)) ? Keyword : NoKeyword;
+            block = block.next();
+        }
+        if (mBlockStates.at(i) == Keyword) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AttachmentKeywordScanner::containsKeyword(const QString &text) const
+{
+    int state = 0;
+    for (int i = 0, total = text.length(); i < total; ++i) {
+        const ushort key = text.at(i).toCaseFolded().unicode();
+        while (state > 0 && !mNodes.at(state).next.contains(key)) {
+            state = mNodes.at(state).fail;
+        }
+        state = mNodes.at(state).next.value(key, 0);
+        for (int length : mNodes.at(state).keywordLengths) {
+            if (isWordBoundary(text, i + 1 - length) && isWordBoundary(text, i + 1)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool AttachmentKeywordScanner::isQuotedLine(const QString &line)
+{
+    // Same as "^([ \t]*([|>:}#]|[A-Za-z]+>))+" in MessageComposer
+    int pos = 0;
+    const int length = line.length();
+    while (pos < length && (line.at(pos) == QLatin1Char(' ') || line.at(pos) == QLatin1Char('\t'))) {
+        ++pos;
+    }
+    if (pos == length) {
+        return false;
+    }
+    const QChar c = line.at(pos);
+    if (c == QLatin1Char('|') || c == QLatin1Char('>') || c == QLatin1Char(':') || c == QLatin1Char('}') || c == QLatin1Char('#')) {
+        return true;
+    }
+    int end = pos;
+    while (end < length && line.at(end).unicode() < 128 && line.at(end).isLetter()) {
+        ++end;
+    }
+    return end > pos && end < length && line.at(end) == QLatin1Char('>');
+}
@@ -0,0 +1,84 @@
+/*
+   Copyright (C) 2026 KDE e.V.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef ATTACHMENTKEYWORDSCANNER_H
+#define ATTACHMENTKEYWORDSCANNER_H
+
+#include "kmail_export.h"
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QRegularExpression>
+#include <QStringList>
+#include <QVector>
+
+class QTextDocument;
+
+/**
+ * Looks for the forgotten attachment keywords in the composer text.
+ *
+ * The keywords are compiled once into an Aho-Corasick automaton, and the
+ * result is cached per text block: only blocks changed since the last
+ * check are scanned again. Quoted blocks are skipped like in
+ * MessageComposer::Util::hasMissingAttachments().
+ */
+class KMAIL_EXPORT AttachmentKeywordScanner : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AttachmentKeywordScanner(QObject *parent = nullptr);
+    ~AttachmentKeywordScanner();
+
+    void setKeywords(const QStringList &keywords);
+    void setDocument(QTextDocument *document);
+
+    /**
+     * Returns true when @p subject or a non-quoted block of the document
+     * contains one of the keywords. A subject of a reply or forward is not
+     * taken into account.
+     */
+    Q_REQUIRED_RESULT bool hasKeyword(const QString &subject);
+
+    Q_REQUIRED_RESULT bool containsKeyword(const QString &text) const;
+    Q_REQUIRED_RESULT static bool isQuotedLine(const QString &line);
+
+private:
+    void slotContentsChange(int position, int charsRemoved, int charsAdded);
+    void resetBlockStates();
+
+    enum BlockState : quint8 {
+        Unknown = 0,
+        NoKeyword,
+        Keyword
+    };
+
+    struct Node {
+        QHash<ushort, int> next;
+        QVector<int> keywordLengths;
+        int fail = 0;
+    };
+
+    QStringList mKeywords;
+    QVector<Node> mNodes;
+    QVector<quint8> mBlockStates;
+    QRegularExpression mReplyForwardPrefix;
+    QPointer<QTextDocument> mDocument;
+};
+
+#endif // ATTACHMENTKEYWORDSCANNER_H
@@ -127,6 +127,13 @@ public: // kmcommand
      * Add an attachment to the list.
      */
     virtual void addAttach(KMime::Content *msgPart) = 0;
+
+    /**
+     * Prevents the message from being sent or saved while attachments are
+     * still being added. Calls nest, each blockSending(true) needs a
+     * matching blockSending(false).
+     */
+    virtual void blockSending(bool block) = 0;
 };
 
 KMAIL_EXPORT Composer *makeComposer(
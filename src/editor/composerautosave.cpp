@@ -0,0 +1,265 @@
+/*
+   Copyright (C) 2026 KDE e.V.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "composerautosave.h"
+#include "kmail_debug.h"
+
+#include <KMime/Content>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace {
+const char partsHeader[] = "X-KMail-AutoSave-Parts";
+
+QByteArray attachmentMetaData(const MessageCore::AttachmentPart::Ptr &part)
+{
+    QByteArray metaData = part->mimeType();
+    metaData += '\0' + part->name().toUtf8();
+    metaData += '\0' + part->fileName().toUtf8();
+    metaData += '\0' + part->description().toUtf8();
+    metaData += '\0' + part->charset();
+    metaData += '\0' + QByteArray::number(part->isAutoEncoding() ? -1 : static_cast<int>(part->encoding()));
+    metaData += '\0' + QByteArray::number(part->isInline());
+    return metaData;
+}
+
+QByteArray attachmentKey(const MessageCore::AttachmentPart::Ptr &part)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(attachmentMetaData(part));
+    hash.addData(part->data());
+    return hash.result().toHex();
+}
+
+bool writeFile(const QString &fileName, const QByteArray &data)
+{
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(KMAIL_LOG) << "Unable to open autosave file" << fileName << file.errorString();
+        return false;
+    }
+    file.write(data);
+    if (!file.commit()) {
+        qCWarning(KMAIL_LOG) << "Unable to write autosave file" << fileName << file.errorString();
+        return false;
+    }
+    return true;
+}
+}
+
+ComposerAutoSave::ComposerAutoSave()
+{
+}
+
+ComposerAutoSave::~ComposerAutoSave()
+{
+}
+
+void ComposerAutoSave::setFileName(const QString &fileName)
+{
+    mFileName = fileName;
+}
+
+QString ComposerAutoSave::fileName() const
+{
+    return mFileName;
+}
+
+QString ComposerAutoSave::autoSaveDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QLatin1String("/kmail2/autosave/");
+}
+
+QString ComposerAutoSave::partFileName(const QByteArray &key) const
+{
+    return autoSaveDirectory() + QLatin1String("parts/") + mFileName + QLatin1Char('-') + QString::fromLatin1(key);
+}
+
+bool ComposerAutoSave::save(const KMime::Message::Ptr &message, const MessageCore::AttachmentPart::List &attachments)
+{
+    if (mFileName.isEmpty()) {
+        return false;
+    }
+    if (!QDir().mkpath(autoSaveDirectory() + QLatin1String("parts"))) {
+        qCWarning(KMAIL_LOG) << "Unable to create autosave directory" << autoSaveDirectory();
+        return false;
+    }
+
+    QList<QByteArray> keys;
+    for (const MessageCore::AttachmentPart::Ptr &part : attachments) {
+        // Hashing is much cheaper than encoding and writing the part again
+        const QByteArray key = attachmentKey(part);
+        const QString partFile = partFileName(key);
+        if (!QFile::exists(partFile) && !writeFile(partFile, encodeAttachment(part))) {
+            return false;
+        }
+        keys.append(key);
+    }
+
+    if (keys.isEmpty()) {
+        message->removeHeader(partsHeader);
+    } else {
+        auto header = new KMime::Headers::Generic(partsHeader);
+        header->from7BitString(keys.join(','));
+        message->setHeader(header);
+    }
+    message->assemble();
+    if (!writeFile(autoSaveDirectory() + mFileName, message->encodedContent())) {
+        return false;
+    }
+    // Drop the parts of attachments which were removed or modified since the last autosave
+    QDir partsDir(autoSaveDirectory() + QLatin1String("parts"));
+    const QStringList partFiles = partsDir.entryList(QStringList() << (mFileName + QLatin1String("-*")), QDir::Files);
+    for (const QString &partFile : partFiles) {
+        const QByteArray key = partFile.mid(mFileName.length() + 1).toLatin1();
+        if (!keys.contains(key)) {
+            partsDir.remove(partFile);
+        }
+    }
+    return true;
+}
+
+void ComposerAutoSave::removeParts()
+{
+    if (mFileName.isEmpty()) {
+        return;
+    }
+    QDir partsDir(autoSaveDirectory() + QLatin1String("parts"));
+    const QStringList partFiles = partsDir.entryList(QStringList() << (mFileName + QLatin1String("-*")), QDir::Files);
+    for (const QString &partFile : partFiles) {
+        partsDir.remove(partFile);
+    }
+}
+
+void ComposerAutoSave::cleanup()
+{
+    if (mFileName.isEmpty()) {
+        return;
+    }
+    QFile::remove(autoSaveDirectory() + mFileName);
+    removeParts();
+}
+
+QByteArray ComposerAutoSave::restore(const QString &filePath, const QByteArray &data, int *missingParts)
+{
+    if (missingParts) {
+        *missingParts = 0;
+    }
+    KMime::Message::Ptr message(new KMime::Message);
+    message->setContent(data);
+    message->parse();
+    const KMime::Headers::Base *header = message->headerByType(partsHeader);
+    if (!header) {
+        return data;
+    }
+
+    const QFileInfo info(filePath);
+    const QString partPrefix = info.absolutePath() + QLatin1String("/parts/") + info.fileName() + QLatin1Char('-');
+    QVector<QByteArray> parts;
+    const QList<QByteArray> keys = header->as7BitString(false).split(',');
+    for (const QByteArray &key : keys) {
+        QFile partFile(partPrefix + QString::fromLatin1(key.trimmed()));
+        if (!partFile.open(QIODevice::ReadOnly)) {
+            qCWarning(KMAIL_LOG) << "Missing autosaved attachment" << partFile.fileName();
+            if (missingParts) {
+                ++*missingParts;
+            }
+            continue;
+        }
+        parts.append(partFile.readAll());
+    }
+
+    message->removeHeader(partsHeader);
+    message->assemble();
+    return assemble(message->encodedContent(), parts);
+}
+
+QByteArray ComposerAutoSave::assemble(const QByteArray &message, const QVector<QByteArray> &parts)
+{
+    if (parts.isEmpty()) {
+        return message;
+    }
+
+    const int headerEnd = message.indexOf("\n\n");
+    const QByteArray head = headerEnd < 0 ? message : message.left(headerEnd + 1);
+    const QByteArray body = headerEnd < 0 ? QByteArray() : message.mid(headerEnd + 2);
+
+    // The Content-* headers describe the text and move into the first part,
+    // everything else stays with the enclosing multipart/mixed message
+    QByteArray messageHeaders;
+    QByteArray contentHeaders;
+    bool isContentHeader = false;
+    const QList<QByteArray> lines = head.split('\n');
+    for (const QByteArray &line : lines) {
+        if (line.isEmpty()) {
+            continue;
+        }
+        if (line.at(0) != ' ' && line.at(0) != '\t') {
+            isContentHeader = line.toLower().startsWith("content-");
+        }
+        (isContentHeader ? contentHeaders : messageHeaders) += line + '\n';
+    }
+
+    const QByteArray boundary = KMime::multiPartBoundary();
+    QByteArray result = messageHeaders;
+    result += "Content-Type: multipart/mixed; boundary=\"" + boundary + "\"\n\n";
+    result += "--" + boundary + '\n' + contentHeaders + '\n' + body;
+    for (const QByteArray &part : parts) {
+        if (!result.endsWith('\n')) {
+            result += '\n';
+        }
+        result += "--" + boundary + '\n' + part;
+    }
+    if (!result.endsWith('\n')) {
+        result += '\n';
+    }
+    result += "--" + boundary + "--\n";
+    return result;
+}
+
+QByteArray ComposerAutoSave::encodeAttachment(const MessageCore::AttachmentPart::Ptr &part)
+{
+    KMime::Content content;
+    content.contentType()->setMimeType(part->mimeType());
+    if (!part->name().isEmpty()) {
+        content.contentType()->setName(part->name(), "utf-8");
+    }
+    if (!part->charset().isEmpty()) {
+        content.contentType()->setCharset(part->charset());
+    }
+    content.contentDisposition()->setDisposition(part->isInline() ? KMime::Headers::CDinline : KMime::Headers::CDattachment);
+    if (!part->fileName().isEmpty()) {
+        content.contentDisposition()->setFilename(part->fileName());
+    }
+    if (!part->description().isEmpty()) {
+        content.contentDescription()->fromUnicodeString(part->description(), "utf-8");
+    }
+    KMime::Headers::contentEncoding encoding = part->encoding();
+    if (part->isAutoEncoding()) {
+        encoding = part->mimeType().startsWith("text/") ? KMime::Headers::CEquPr : KMime::Headers::CEbase64;
+    }
+    content.contentTransferEncoding()->setEncoding(encoding);
+    content.setBody(part->data());
+    content.assemble();
+    return content.encodedContent();
+}
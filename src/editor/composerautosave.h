@@ -0,0 +1,77 @@
+/*
+   Copyright (C) 2026 KDE e.V.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef COMPOSERAUTOSAVE_H
+#define COMPOSERAUTOSAVE_H
+
+#include "kmail_export.h"
+#include <MessageCore/AttachmentPart>
+#include <KMime/Message>
+#include <QString>
+#include <QVector>
+
+/**
+ * Writes the autosave copy of a composer incrementally.
+ *
+ * Attachments are encoded once and stored next to the autosave file,
+ * keyed by their content. The autosave file itself only holds the
+ * headers and the text, plus a header listing the stored parts, so
+ * that subsequent autosaves do not re-encode or rewrite attachments.
+ * restore() puts the complete message back together for crash recovery.
+ */
+class KMAIL_EXPORT ComposerAutoSave
+{
+public:
+    ComposerAutoSave();
+    ~ComposerAutoSave();
+
+    void setFileName(const QString &fileName);
+    Q_REQUIRED_RESULT QString fileName() const;
+
+    /**
+     * Writes @p message, which must not contain the attachments, and
+     * stores the encoded @p attachments that were not stored yet.
+     */
+    bool save(const KMime::Message::Ptr &message, const MessageCore::AttachmentPart::List &attachments);
+
+    /** Removes the autosave file and its stored attachments. */
+    void cleanup();
+
+    /** Removes the stored attachments only. */
+    void removeParts();
+
+    /**
+     * Returns the complete message for the autosave file at @p filePath
+     * whose content is @p data. Files written without stored attachments
+     * are returned unchanged. The number of stored attachments which could
+     * not be read is returned in @p missingParts.
+     */
+    static QByteArray restore(const QString &filePath, const QByteArray &data, int *missingParts = nullptr);
+
+    static QByteArray assemble(const QByteArray &message, const QVector<QByteArray> &parts);
+    static QByteArray encodeAttachment(const MessageCore::AttachmentPart::Ptr &part);
+    static QString autoSaveDirectory();
+
+private:
+    Q_DISABLE_COPY(ComposerAutoSave)
+    QString partFileName(const QByteArray &key) const;
+    QString mFileName;
+};
+
+#endif // COMPOSERAUTOSAVE_H
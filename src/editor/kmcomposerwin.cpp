@@ -25,7 +25,9 @@
 // KMail includes
 #include "attachment/attachmentcontroller.h"
 #include "attachment/attachmentview.h"
+#include "attachmentkeywordscanner.h"
 #include "codec/codecaction.h"
+#include "composerautosave.h"
 #include "custommimeheader.h"
 #include "editor/kmcomposereditorng.h"
 #include "editor/plugininterface/kmailplugineditorcheckbeforesendmanagerinterface.h"
@@ -42,6 +44,7 @@
 #include "job/saveasfilejob.h"
 #include "job/savedraftjob.h"
 #include "job/dndfromarkjob.h"
+#include "job/forwardattachedmessagesjob.h"
 #include "kconfigwidgets_version.h"
 #include "kmail_debug.h"
 #include "kmcommands.h"
@@ -99,7 +102,6 @@
 
 #include <MailCommon/FolderCollectionMonitor>
 #include <MailCommon/FolderRequester>
-#include <MailCommon/FolderSettings>
 #include <MailCommon/MailKernel>
 
 #include <MailTransport/Transport>
@@ -152,7 +154,7 @@
 
 #include <QGpgME/Protocol>
 #include <QGpgME/ExportJob>
-#include <QGpgME/KeyForMailboxJob>
+#include <QGpgME/KeyListJob>
 
 // KDE Frameworks includes
 #include <KActionCollection>
@@ -189,6 +191,7 @@
 #include <QSplitter>
 #include <QStandardPaths>
 #include <QStatusBar>
+#include <QUuid>
 #include <QMenuBar>
 #include <MessageComposer/PluginEditorConverterInitialData>
 #include <MessageComposer/PluginEditorConverterBeforeConvertingData>
@@ -203,6 +206,16 @@ using MailTransport::Transport;
 
 Q_DECLARE_METATYPE(MessageComposer::Recipient::Ptr)
 
+namespace {
+struct CachedKey {
+    GpgME::Key key;
+    GpgME::UserID userID;
+};
+// Recipient keys found by any composer window, by lower case mailbox
+typedef QHash<QString, CachedKey> RecipientKeyCache;
+Q_GLOBAL_STATIC(RecipientKeyCache, sRecipientKeyCache)
+}
+
 KMail::Composer *KMail::makeComposer(const KMime::Message::Ptr &msg, bool lastSignState, bool lastEncryptState, Composer::TemplateContext context, uint identity, const QString &textSelection,
                                      const QString &customTemplate)
 {
@@ -303,6 +316,17 @@ KMComposerWin::KMComposerWin(const KMime::Message::Ptr &aMsg, bool lastSignState
     mEdtFrom->setRecentAddressConfig(MessageComposer::MessageComposerSettings::self()->config());
     mEdtFrom->setToolTip(i18n("Set the \"From:\" email address for this message"));
 
+    // Recipient lines added in a burst (pasting a list, expanding a group) are
+    // looked up with a single keylisting and the encryption state is evaluated once
+    mKeyLookupTimer = new QTimer(this);
+    mKeyLookupTimer->setSingleShot(true);
+    mKeyLookupTimer->setInterval(50);
+    connect(mKeyLookupTimer, &QTimer::timeout, this, &KMComposerWin::slotStartKeyLookups);
+    mEncryptionStateTimer = new QTimer(this);
+    mEncryptionStateTimer->setSingleShot(true);
+    mEncryptionStateTimer->setInterval(0);
+    connect(mEncryptionStateTimer, &QTimer::timeout, this, &KMComposerWin::slotRecipientEditorFocusChanged);
+
     MessageComposer::RecipientsEditor *recipientsEditor = new MessageComposer::RecipientsEditor(mHeadersArea);
     recipientsEditor->setRecentAddressConfig(MessageComposer::MessageComposerSettings::self()->config());
     connect(recipientsEditor, &MessageComposer::RecipientsEditor::completionModeChanged, this, &KMComposerWin::slotCompletionModeChanged);
@@ -409,6 +433,8 @@ KMComposerWin::KMComposerWin(const KMime::Message::Ptr &aMsg, bool lastSignState
         mVerifyMissingAttachment->setSingleShot(true);
         mVerifyMissingAttachment->setInterval(1000 * 5);
         connect(mVerifyMissingAttachment, &QTimer::timeout, this, &KMComposerWin::slotVerifyMissingAttachmentTimeout);
+        mAttachmentKeywordScanner = new AttachmentKeywordScanner(this);
+        mAttachmentKeywordScanner->setDocument(composerEditorNg->document());
     }
     connect(attachmentController, &KMail::AttachmentController::fileAttached, mAttachmentMissing, &AttachmentMissingWarning::slotFileAttached);
 
@@ -488,6 +514,9 @@ KMComposerWin::KMComposerWin(const KMime::Message::Ptr &aMsg, bool lastSignState
     mDummyComposer = new MessageComposer::Composer(this);
     mDummyComposer->globalPart()->setParentWidgetForGui(this);
 
+    mAutoSave = new ComposerAutoSave;
+    mAutoSave->setFileName(QUuid::createUuid().toString());
+
     KConfigGroup grp(KMKernel::self()->config()->group("Composer"));
     setAutoSaveSettings(grp, true);
 }
@@ -503,6 +532,7 @@ KMComposerWin::~KMComposerWin()
     }
 
     delete mComposerBase;
+    delete mAutoSave;
 }
 
 void KMComposerWin::slotSpellCheckingLanguage(const QString &language)
@@ -523,7 +553,8 @@ void KMComposerWin::slotEditorTextChanged()
     mFindNextText->setEnabled(textIsNotEmpty);
     mReplaceText->setEnabled(textIsNotEmpty);
     mSelectAll->setEnabled(textIsNotEmpty);
-    if (mVerifyMissingAttachment && !mVerifyMissingAttachment->isActive()) {
+    if (mVerifyMissingAttachment) {
+        // Wait for a pause in typing
         mVerifyMissingAttachment->start();
     }
 }
@@ -1702,6 +1733,7 @@ void KMComposerWin::setMessage(const KMime::Message::Ptr &newMsg, bool lastSignS
 void KMComposerWin::setAutoSaveFileName(const QString &fileName)
 {
     mComposerBase->setAutoSaveFileName(fileName);
+    mAutoSave->setFileName(fileName);
 }
 
 void KMComposerWin::setSigningAndEncryptionDisabled(bool v)
@@ -1799,6 +1831,7 @@ bool KMComposerWin::queryClose()
         //else fall through: return true
     }
     mComposerBase->cleanupAutoSave();
+    mAutoSave->cleanup();
 
     if (!mMiscComposers.isEmpty()) {
         qCWarning(KMAIL_LOG) << "Tried to close while composer was active";
@@ -1832,7 +1865,14 @@ void KMComposerWin::autoSaveMessage(bool force)
     if (isComposerModified() || force) {
         applyComposerSetting(mComposerBase);
         mComposerBase->saveMailSettings();
-        mComposerBase->autoSaveMessage();
+        if (mEncryptAction->isChecked()) {
+            // Encrypted messages keep going through the complete composer
+            mAutoSave->cleanup();
+            mComposerBase->autoSaveMessage();
+            mFullAutoSaveWritten = true;
+        } else {
+            incrementalAutoSave();
+        }
         if (!force) {
             mWasModified = true;
             changeModifiedState(false);
@@ -1842,6 +1882,65 @@ void KMComposerWin::autoSaveMessage(bool force)
     }
 }
 
+void KMComposerWin::incrementalAutoSave()
+{
+    if (mAutoSaveComposer) {
+        // Still writing the previous autosave, the next timeout will catch up
+        return;
+    }
+
+    // Compose headers and text only, attachments are stored separately by
+    // ComposerAutoSave and only encoded again when they change
+    mAutoSaveAttachments = mComposerBase->attachmentModel()->attachments();
+    mAutoSaveComposer = createSimpleComposer();
+    const auto parts = mAutoSaveComposer->attachmentParts();
+    for (const MessageCore::AttachmentPart::Ptr &part : parts) {
+        mAutoSaveComposer->removeAttachmentPart(part);
+    }
+    connect(mAutoSaveComposer, &MessageComposer::Composer::result, this, &KMComposerWin::slotAutoSaveComposeResult);
+    mAutoSaveComposer->start();
+}
+
+void KMComposerWin::slotAutoSaveComposeResult(KJob *job)
+{
+    Q_ASSERT(job == mAutoSaveComposer);
+    mAutoSaveComposer = nullptr;
+    const MessageCore::AttachmentPart::List attachments = mAutoSaveAttachments;
+    mAutoSaveAttachments.clear();
+
+    if (job->error() != MessageComposer::Composer::NoError) {
+        slotSendFailed(job->errorString(), MessageComposer::ComposerViewBase::AutoSave);
+        return;
+    }
+
+    MessageComposer::Composer *composer = static_cast<MessageComposer::Composer *>(job);
+    Q_ASSERT(composer->resultMessages().size() == 1);
+    const KMime::Message::Ptr message = composer->resultMessages().constFirst();
+    // Keep the identity, transport and folder settings stored by saveMailSettings()
+    if (mMsg) {
+        const auto headers = mMsg->headers();
+        for (const KMime::Headers::Base *header : headers) {
+            if (qstrnicmp(header->type(), "X-KMail-", 8) == 0) {
+                auto copy = new KMime::Headers::Generic(header->type());
+                copy->from7BitString(header->as7BitString(false));
+                message->setHeader(copy);
+            }
+        }
+    }
+
+    if (mFullAutoSaveWritten) {
+        // Drop the copy written while the message was encrypted before writing
+        // ours: both use the same file name after a dead letter was recovered.
+        // Restart the autosave timer which cleanupAutoSave() stops
+        mComposerBase->cleanupAutoSave();
+        mComposerBase->updateAutoSave();
+        mFullAutoSaveWritten = false;
+    }
+    if (!mAutoSave->save(message, attachments)) {
+        slotSendFailed(i18n("Unable to write the autosave file."), MessageComposer::ComposerViewBase::AutoSave);
+    }
+}
+
 bool KMComposerWin::encryptToSelf() const
 {
     return MessageComposer::MessageComposerSettings::self()->cryptoEncryptToSelf();
@@ -1860,6 +1959,7 @@ void KMComposerWin::slotSendSuccessful()
 {
     setModified(false);
     mComposerBase->cleanupAutoSave();
+    mAutoSave->cleanup();
     mFolder = Akonadi::Collection(); // see dtor
     close();
 }
@@ -2121,8 +2221,10 @@ bool KMComposerWin::insertFromMimeData(const QMimeData *source, bool forceAttach
             if (!url.isLocalFile()) {
                 allLocalURLs = false;
             }
-            const Akonadi::Item item = Akonadi::Item::fromUrl(url);
+            Akonadi::Item item = Akonadi::Item::fromUrl(url);
             if (item.isValid()) {
+                // Dragged items usually tell their mime type, which saves fetching them to find out
+                item.setMimeType(QUrlQuery(url).queryItemValue(QStringLiteral("type")));
                 items << item;
             } else {
                 const Akonadi::Collection collection = Akonadi::Collection::fromUrl(url);
@@ -2157,10 +2259,7 @@ bool KMComposerWin::insertFromMimeData(const QMimeData *source, bool forceAttach
             return true;
         } else {
             if (!items.isEmpty()) {
-                Akonadi::ItemFetchJob *itemFetchJob = new Akonadi::ItemFetchJob(items, this);
-                itemFetchJob->fetchScope().fetchFullPayload(true);
-                itemFetchJob->fetchScope().setAncestorRetrieval(Akonadi::ItemFetchScope::Parent);
-                connect(itemFetchJob, &Akonadi::ItemFetchJob::result, this, &KMComposerWin::slotFetchJob);
+                addAttachmentItems(items);
             }
             if (!collections.isEmpty()) {
                 qCDebug(KMAIL_LOG) << "Collection dnd not supported";
@@ -2190,6 +2289,44 @@ void KMComposerWin::slotPasteAsAttachment()
     }
 }
 
+void KMComposerWin::addAttachmentItems(const Akonadi::Item::List &items)
+{
+    Akonadi::Item::List messages;
+    Akonadi::Item::List otherItems;
+    for (const Akonadi::Item &item : items) {
+        if (item.mimeType() == KMime::Message::mimeType()) {
+            messages << item;
+        } else {
+            otherItems << item;
+        }
+    }
+    if (!messages.isEmpty()) {
+        attachMessageItems(messages);
+    }
+    if (!otherItems.isEmpty()) {
+        Akonadi::ItemFetchJob *itemFetchJob = new Akonadi::ItemFetchJob(otherItems, this);
+        itemFetchJob->fetchScope().fetchFullPayload(true);
+        itemFetchJob->fetchScope().setAncestorRetrieval(Akonadi::ItemFetchScope::Parent);
+        connect(itemFetchJob, &Akonadi::ItemFetchJob::result, this, &KMComposerWin::slotFetchJob);
+    }
+}
+
+void KMComposerWin::attachMessageItems(const Akonadi::Item::List &items)
+{
+    // Items which already carry their payload are not fetched again
+    ForwardAttachedMessagesJob *job = new ForwardAttachedMessagesJob(this);
+    job->setItems(items);
+    job->setMode(ForwardAttachedMessagesJob::Attached);
+    job->setComposer(this);
+    job->start();
+}
+
+void KMComposerWin::blockSending(bool block)
+{
+    mSendBlockCount += block ? 1 : -1;
+    Q_ASSERT(mSendBlockCount >= 0);
+}
+
 void KMComposerWin::slotFetchJob(KJob *job)
 {
     if (showErrorMessage(job)) {
@@ -2206,21 +2343,7 @@ void KMComposerWin::slotFetchJob(KJob *job)
     }
 
     if (items.first().mimeType() == KMime::Message::mimeType()) {
-        uint identity = 0;
-        if (items.at(0).isValid()) {
-            const Akonadi::Collection parentCollection = items.at(0).parentCollection();
-            if (parentCollection.isValid()) {
-                const QString resourceName = parentCollection.resource();
-                if (!resourceName.isEmpty()) {
-                    QSharedPointer<MailCommon::FolderSettings> fd(MailCommon::FolderSettings::forCollection(parentCollection, false));
-                    if (fd) {
-                        identity = fd->identity();
-                    }
-                }
-            }
-        }
-        KMCommand *command = new KMForwardAttachedCommand(this, items, identity, this);
-        command->start();
+        attachMessageItems(items);
     } else {
         for (const Akonadi::Item &item : items) {
             QString attachmentName = QStringLiteral("attachment");
@@ -2435,7 +2558,7 @@ void KMComposerWin::forceDisableHtml()
 
 bool KMComposerWin::isComposing() const
 {
-    return mComposerBase && mComposerBase->isComposing();
+    return (mComposerBase && mComposerBase->isComposing()) || mAutoSaveComposer;
 }
 
 void KMComposerWin::disableForgottenAttachmentsCheck()
@@ -2496,6 +2619,13 @@ void KMComposerWin::printComposeResult(KJob *job, bool preview)
 
 void KMComposerWin::doSend(MessageComposer::MessageSender::SendMethod method, MessageComposer::MessageSender::SaveIn saveIn, bool willSendItWithoutReediting)
 {
+    if (mSendBlockCount > 0) {
+        KMessageBox::sorry(this,
+                           i18n("Some messages are still being attached. "
+                                "Please wait until all of them have been added."));
+        return;
+    }
+
     const MessageComposer::ComposerViewBase::MissingAttachment forgotAttachment = userForgotAttachment();
     if ((forgotAttachment == MessageComposer::ComposerViewBase::FoundMissingAttachmentAndAddedAttachment)
         || (forgotAttachment == MessageComposer::ComposerViewBase::FoundMissingAttachmentAndCancel)) {
@@ -2830,22 +2960,21 @@ void KMComposerWin::slotDelayedCheckSendNow()
 
 void KMComposerWin::slotCheckSendNow()
 {
+    // The job splits the address lists itself, so each address is parsed only once
     QStringList lst {mComposerBase->to()};
     const QString ccStr = mComposerBase->cc();
     if (!ccStr.isEmpty()) {
-        lst << ccStr.split(QLatin1Char(','));
+        lst << ccStr;
     }
     const QString bccStr = mComposerBase->bcc();
     if (!bccStr.isEmpty()) {
-        lst << bccStr.split(QLatin1Char(','));
+        lst << bccStr;
     }
     if (lst.isEmpty()) {
         slotCheckSendNowStep2();
     } else {
         PotentialPhishingEmailJob *job = new PotentialPhishingEmailJob(this);
-        KConfigGroup group(KSharedConfig::openConfig(), "PotentialPhishing");
-        const QStringList whiteList = group.readEntry("whiteList", QStringList());
-        job->setEmailWhiteList(whiteList);
+        job->setEmailWhiteList(PotentialPhishingEmailJob::emailWhiteList());
         job->setPotentialPhishingEmails(lst);
         connect(job, &PotentialPhishingEmailJob::potentialPhishingEmailsFound, this, &KMComposerWin::slotPotentialPhishingEmailsFound);
         job->start();
@@ -3299,7 +3428,11 @@ void KMComposerWin::slotAttachMissingFile()
 
 void KMComposerWin::slotVerifyMissingAttachmentTimeout()
 {
-    if (mComposerBase->hasMissingAttachments(KMailSettings::self()->attachmentKeywords())) {
+    if (mComposerBase->attachmentModel()->rowCount() > 0) {
+        return;
+    }
+    mAttachmentKeywordScanner->setKeywords(KMailSettings::self()->attachmentKeywords());
+    if (mAttachmentKeywordScanner->hasKeyword(subject())) {
         mAttachmentMissing->animatedShow();
     }
 }
@@ -3310,6 +3443,8 @@ void KMComposerWin::slotExplicitClosedMissingAttachment()
         mVerifyMissingAttachment->stop();
         delete mVerifyMissingAttachment;
         mVerifyMissingAttachment = nullptr;
+        delete mAttachmentKeywordScanner;
+        mAttachmentKeywordScanner = nullptr;
     }
 }
 
@@ -3397,14 +3532,14 @@ void KMComposerWin::slotRecipientEditorLineAdded(KPIM::MultiplyingLine *line_)
         this->slotRecipientLineIconClicked(line);
     });
     connect(line, &MessageComposer::RecipientLineNG::destroyed,
-            this, &KMComposerWin::slotRecipientEditorFocusChanged,
+            mEncryptionStateTimer, static_cast<void (QTimer::*)()>(&QTimer::start),
             Qt::QueuedConnection);
     connect(line, &MessageComposer::RecipientLineNG::activeChanged,
             this, [this, line]() {
         this->slotRecipientFocusLost(line);
     });
 
-    slotRecipientEditorFocusChanged();
+    mEncryptionStateTimer->start();
 }
 
 void KMComposerWin::slotRecipientEditorFocusChanged()
@@ -3414,35 +3549,37 @@ void KMComposerWin::slotRecipientEditorFocusChanged()
         return;
     }
 
+    // There are still key lookups queued or running, slotKeyListResult()
+    // will call us once the whole batch has been resolved
+    if (mPendingKeyLookupCount > 0) {
+        return;
+    }
+
     // Focus changed, which basically means that user "committed" a new recipient.
     // If we have at least one recipient that does not have a key, disable encryption
     // (unless user enabled it manually), because we want to encrypt by default,
     // but not by force
-    bool encrypt = false;
+    int keysOk = 0;
+    int keysMissing = 0;
     const auto lst = mComposerBase->recipientsEditor()->lines();
     for (auto line_ : lst) {
         auto line = qobject_cast<MessageComposer::RecipientLineNG *>(line_);
 
-        // There's still a lookup job running, so wait, slotKeyForMailBoxResult()
-        // will call us if the job returns empty key
-        if (line->property("keyLookupJob").isValid()) {
-            return;
-        }
-
         const auto keyStatus = static_cast<CryptoKeyState>(line->property("keyStatus").toInt());
         if (keyStatus == NoState) {
             continue;
         }
 
         if (!line->recipient()->isEmpty() && keyStatus != KeyOk) {
-            setEncryption(false, false);
-            return;
+            ++keysMissing;
+        } else {
+            ++keysOk;
         }
-
-        encrypt = true;
     }
 
-    if (encrypt) {
+    if (keysMissing > 0) {
+        setEncryption(false, false);
+    } else if (keysOk > 0) {
         setEncryption(true, false);
     }
 }
@@ -3461,8 +3598,33 @@ void KMComposerWin::slotRecipientLineIconClicked(MessageComposer::RecipientLineN
     }
 }
 
+void KMComposerWin::cancelKeyLookup(MessageComposer::RecipientLineNG *line)
+{
+    // A lookup still running for the line is ignored when its result comes back
+    const QString previousMailbox = line->property("keyLookupMailbox").toString();
+    if (previousMailbox.isEmpty()) {
+        return;
+    }
+    auto pending = mPendingKeyLookups.find(previousMailbox);
+    if (pending != mPendingKeyLookups.end()) {
+        pending->removeAll(line);
+        if (pending->isEmpty()) {
+            mPendingKeyLookups.erase(pending);
+        }
+    }
+    auto running = mRunningKeyLookups.find(previousMailbox);
+    if (running != mRunningKeyLookups.end()) {
+        running->removeAll(line);
+    }
+    line->setProperty("keyLookupMailbox", QVariant());
+    --mPendingKeyLookupCount;
+}
+
 void KMComposerWin::slotRecipientAdded(MessageComposer::RecipientLineNG *line)
 {
+    // The line now waits for its current mailbox only, if for anything
+    cancelKeyLookup(line);
+
     // User has disabled encryption, don't bother checking the key...
     if (!mEncryptAction->isChecked() && mEncryptAction->property("setByUser").toBool()) {
         return;
@@ -3477,39 +3639,137 @@ void KMComposerWin::slotRecipientAdded(MessageComposer::RecipientLineNG *line)
         return;
     }
 
-    const auto protocol = QGpgME::openpgp();
     // If we don't have gnupg we can't look for keys
-    if (!protocol) {
+    if (!QGpgME::openpgp()) {
         return;
     }
 
     auto recipient = line->data().dynamicCast<MessageComposer::Recipient>();
-    // check if is an already running key lookup job and if so, cancel it
-    // this is to prevent a slower job overwriting results of the job that we
-    // are about to start now.
-    const auto runningJob = line->property("keyLookupJob").value<QPointer<QGpgME::KeyForMailboxJob> >();
-    if (runningJob) {
-        disconnect(runningJob.data(), &QGpgME::KeyForMailboxJob::result, this, &KMComposerWin::slotKeyForMailBoxResult);
-        runningJob->slotCancel();
-        line->setProperty("keyLookupJob", QVariant());
+    QString dummy, addrSpec;
+    if (KEmailAddress::splitAddress(recipient->email(), dummy, addrSpec, dummy) != KEmailAddress::AddressOk) {
+        addrSpec = recipient->email();
+    }
+    const QString mailbox = addrSpec.toLower();
+
+    const auto cached = sRecipientKeyCache->constFind(mailbox);
+    if (cached != sRecipientKeyCache->cend()) {
+        applyKeyToRecipientLine(line, cached->key, cached->userID);
+        mEncryptionStateTimer->start();
+        return;
+    }
+    if (mMailboxesWithoutKey.contains(mailbox)) {
+        applyKeyToRecipientLine(line, GpgME::Key(), GpgME::UserID());
+        return;
     }
 
-    QGpgME::KeyForMailboxJob *job = protocol->keyForMailboxJob();
+    line->setProperty("keyLookupMailbox", mailbox);
+    ++mPendingKeyLookupCount;
+    mPendingKeyLookups[mailbox].append(QPointer<MessageComposer::RecipientLineNG>(line));
+    if (!mKeyListJob) {
+        mKeyLookupTimer->start();
+    }
+}
+
+void KMComposerWin::slotStartKeyLookups()
+{
+    if (mKeyListJob || mPendingKeyLookups.isEmpty()) {
+        return;
+    }
+
+    mRunningKeyLookups = mPendingKeyLookups;
+    mPendingKeyLookups.clear();
+    mFoundKeys.clear();
+
+    const auto protocol = QGpgME::openpgp();
+    QGpgME::KeyListJob *job = protocol ? protocol->keyListJob(false, false, true) : nullptr;
     if (!job) {
-        line->setProperty("keyStatus", NoKey);
-        recipient->setEncryptionAction(Kleo::Impossible);
+        slotKeyListResult(GpgME::KeyListResult());
         return;
     }
 
-    QString dummy, addrSpec;
-    if (KEmailAddress::splitAddress(recipient->email(), dummy, addrSpec, dummy) != KEmailAddress::AddressOk) {
-        addrSpec = recipient->email();
+    QStringList patterns;
+    patterns.reserve(mRunningKeyLookups.size());
+    for (auto it = mRunningKeyLookups.cbegin(), end = mRunningKeyLookups.cend(); it != end; ++it) {
+        // angle brackets make gpg match the email address exactly
+        patterns.append(QLatin1Char('<') + it.key() + QLatin1Char('>'));
+    }
+
+    mKeyListJob = job;
+    connect(job, &QGpgME::KeyListJob::nextKey, this, [this](const GpgME::Key &key) {
+        mFoundKeys.push_back(key);
+    });
+    connect(job, &QGpgME::KeyListJob::result, this, &KMComposerWin::slotKeyListResult);
+    const GpgME::Error err = job->start(patterns, false);
+    if (err) {
+        qCWarning(KMAIL_LOG) << "Unable to start key lookup:" << err.asString();
+        mKeyListJob = nullptr;
+        slotKeyListResult(GpgME::KeyListResult());
+    }
+}
+
+void KMComposerWin::slotKeyListResult(const GpgME::KeyListResult &)
+{
+    mKeyListJob = nullptr;
+
+    // Check if the encryption was explicitly disabled while the job was running
+    const bool disabledByUser = !mEncryptAction->isChecked() && mEncryptAction->property("setByUser").toBool();
+
+    bool foundKey = false;
+    for (auto it = mRunningKeyLookups.cbegin(), end = mRunningKeyLookups.cend(); it != end; ++it) {
+        const QString &mailbox = it.key();
+        CachedKey best;
+        for (const GpgME::Key &key : qAsConst(mFoundKeys)) {
+            if (key.isRevoked() || key.isExpired() || key.isDisabled() || key.isInvalid() || !key.canEncrypt()) {
+                continue;
+            }
+            const auto userIDs = key.userIDs();
+            for (const GpgME::UserID &userID : userIDs) {
+                if (userID.isRevoked() || userID.isInvalid()) {
+                    continue;
+                }
+                QString email = QString::fromUtf8(userID.email());
+                if (email.startsWith(QLatin1Char('<')) && email.endsWith(QLatin1Char('>'))) {
+                    email = email.mid(1, email.length() - 2);
+                }
+                if (email.compare(mailbox, Qt::CaseInsensitive) != 0) {
+                    continue;
+                }
+                if (best.key.isNull() || userID.validity() > best.userID.validity()) {
+                    best.key = key;
+                    best.userID = userID;
+                }
+            }
+        }
+        if (best.key.isNull()) {
+            // The user may still import a key, so this is only kept for this window
+            mMailboxesWithoutKey.insert(mailbox);
+        } else {
+            sRecipientKeyCache->insert(mailbox, best);
+        }
+
+        for (const auto &line : it.value()) {
+            // A line is queued for one mailbox at a time, so every entry left
+            // here is still waiting, even if it has been removed meanwhile
+            --mPendingKeyLookupCount;
+            if (!line) {
+                continue;
+            }
+            line->setProperty("keyLookupMailbox", QVariant());
+            if (!disabledByUser) {
+                applyKeyToRecipientLine(line, best.key, best.userID);
+                foundKey |= !best.key.isNull();
+            }
+        }
+    }
+    mRunningKeyLookups.clear();
+    mFoundKeys.clear();
+
+    if (!mPendingKeyLookups.isEmpty()) {
+        mKeyLookupTimer->start();
+    } else if (foundKey) {
+        // Recipients without a key only turn encryption off once they lose focus
+        slotRecipientEditorFocusChanged();
     }
-    line->setProperty("keyLookupJob", QVariant::fromValue(QPointer<QGpgME::KeyForMailboxJob>(job)));
-    job->setProperty("recipient", QVariant::fromValue(recipient));
-    job->setProperty("line", QVariant::fromValue(QPointer<MessageComposer::RecipientLineNG>(line)));
-    connect(job, &QGpgME::KeyForMailboxJob::result, this, &KMComposerWin::slotKeyForMailBoxResult);
-    job->start(addrSpec, true);
 }
 
 void KMComposerWin::slotRecipientFocusLost(MessageComposer::RecipientLineNG *line)
@@ -3527,7 +3787,7 @@ void KMComposerWin::slotRecipientFocusLost(MessageComposer::RecipientLineNG *lin
         return;
     }
 
-    if (line->property("keyLookupJob").toBool()) {
+    if (line->property("keyLookupMailbox").isValid()) {
         return;
     }
 
@@ -3537,24 +3797,13 @@ void KMComposerWin::slotRecipientFocusLost(MessageComposer::RecipientLineNG *lin
     }
 }
 
-void KMComposerWin::slotKeyForMailBoxResult(const GpgME::KeyListResult &, const GpgME::Key &key, const GpgME::UserID &userID)
+void KMComposerWin::applyKeyToRecipientLine(MessageComposer::RecipientLineNG *line, const GpgME::Key &key, const GpgME::UserID &userID)
 {
-    QObject *job = sender();
-    Q_ASSERT(job);
-
-    // Check if the encryption was explicitly disabled while the job was running
-    if (!mEncryptAction->isChecked() && mEncryptAction->property("setByUser").toBool()) {
-        return;
-    }
-
-    auto recipient = job->property("recipient").value<MessageComposer::Recipient::Ptr>();
-    auto line = job->property("line").value<QPointer<MessageComposer::RecipientLineNG> >();
-
-    if (!recipient || !line) {
+    auto recipient = line->data().dynamicCast<MessageComposer::Recipient>();
+    if (!recipient) {
         return;
     }
 
-    line->setProperty("keyLookupJob", QVariant());
     if (key.isNull()) {
         recipient->setEncryptionAction(Kleo::Impossible); // no key
         line->setIcon(QIcon());
@@ -3593,8 +3842,6 @@ void KMComposerWin::slotKeyForMailBoxResult(const GpgME::KeyListResult &, const
 
         line->setProperty("keyStatus", KeyOk);
         line->setIcon(KIconUtils::addOverlay(icon, overlay, Qt::BottomRightCorner), tooltip);
-
-        slotRecipientEditorFocusChanged();
     }
 }
 
@@ -31,7 +31,11 @@
 #include <MessageComposer/PluginEditorConvertTextInterface>
 // Qt includes
 #include <QFont>
+#include <QHash>
 #include <QList>
+#include <QPointer>
+#include <QSet>
+#include <QVector>
 
 // LIBKDEPIM includes
 #include "MessageComposer/RichTextComposerNg"
@@ -41,10 +45,13 @@
 // KDEPIMLIBS includes
 #include <kmime/kmime_message.h>
 #include <kmime/kmime_headers.h>
+#include <AkonadiCore/Item>
 
 // Other includes
 #include "Libkleo/Enum"
+#include <gpgme++/key.h>
 #include <messagecomposer/composerviewbase.h>
+#include <MessageCore/AttachmentPart>
 
 class QUrl;
 
@@ -75,6 +82,8 @@ class KMailPluginEditorInitManagerInterface;
 class IncorrectIdentityFolderWarning;
 class KMailPluginEditorConvertTextManagerInterface;
 class KMailPluginGrammarEditorManagerInterface;
+class ComposerAutoSave;
+class AttachmentKeywordScanner;
 namespace MailTransport {
 class Transport;
 }
@@ -105,10 +114,12 @@ class CustomToolsWidgetNg;
 class LineEditWithAutoCorrection;
 }
 
+namespace QGpgME {
+class KeyListJob;
+}
+
 namespace GpgME {
 class KeyListResult;
-class Key;
-class UserID;
 }
 
 //-----------------------------------------------------------------------------
@@ -208,6 +219,14 @@ public: // kmkernel, kmcommands, callback
 
     bool insertFromMimeData(const QMimeData *source, bool forceAttachment = false);
 
+    /**
+     * Attaches Akonadi items. Messages are only referenced until they get
+     * attached, their payload is fetched once, in chunks.
+     */
+    void addAttachmentItems(const Akonadi::Item::List &items);
+
+    void blockSending(bool block) override;
+
     void setCollectionForNewMessage(const Akonadi::Collection &folder) override;
 
     void addExtraCustomHeaders(const QMap<QByteArray, QString> &header) override;
@@ -355,6 +374,7 @@ private Q_SLOTS:
     void slotConfigChanged();
 
     void slotPrintComposeResult(KJob *job);
+    void slotAutoSaveComposeResult(KJob *job);
 
     void slotSendFailed(const QString &msg, MessageComposer::ComposerViewBase::FailedType type);
     void slotSendSuccessful();
@@ -394,7 +414,8 @@ private Q_SLOTS:
     void slotRecipientAdded(MessageComposer::RecipientLineNG *line);
     void slotRecipientLineIconClicked(MessageComposer::RecipientLineNG *line);
     void slotRecipientFocusLost(MessageComposer::RecipientLineNG *line);
-    void slotKeyForMailBoxResult(const GpgME::KeyListResult &result, const GpgME::Key &key, const GpgME::UserID &userID);
+    void slotStartKeyLookups();
+    void slotKeyListResult(const GpgME::KeyListResult &result);
 
     void slotDelayedCheckSendNow();
     void slotUpdateComposer(const KIdentityManagement::Identity &ident, const KMime::Message::Ptr &msg, uint uoid, uint uoldId, bool wasModified);
@@ -428,6 +449,8 @@ private:
     void updateSignature(uint uoid, uint uOldId);
     Kleo::CryptoMessageFormat cryptoMessageFormat() const;
     void printComposeResult(KJob *job, bool preview);
+    void incrementalAutoSave();
+    void attachMessageItems(const Akonadi::Item::List &items);
     void printComposer(bool preview);
     /**
      * Install grid management and header fields. If fields exist that
@@ -530,6 +553,8 @@ private:
         KeyOk,
         NoKey
     };
+    void cancelKeyLookup(MessageComposer::RecipientLineNG *line);
+    void applyKeyToRecipientLine(MessageComposer::RecipientLineNG *line, const GpgME::Key &key, const GpgME::UserID &userID);
     void slotToggleMenubar(bool dontShowWarning);
 
     void slotCryptoModuleSelected();
@@ -626,6 +651,10 @@ private:
     MessageComposer::Composer *mDummyComposer = nullptr;
     // used for auto saving, printing, etc. Not for sending, which happens in ComposerViewBase
     QList< MessageComposer::Composer * > mMiscComposers;
+    MessageComposer::Composer *mAutoSaveComposer = nullptr;
+    MessageCore::AttachmentPart::List mAutoSaveAttachments;
+    ComposerAutoSave *mAutoSave = nullptr;
+    bool mFullAutoSaveWritten = false;
 
     int mLabelWidth = 0;
 
@@ -640,6 +669,7 @@ private:
     AttachmentMissingWarning *mAttachmentMissing = nullptr;
     ExternalEditorWarning *mExternalEditorWarning = nullptr;
     QTimer *mVerifyMissingAttachment = nullptr;
+    AttachmentKeywordScanner *mAttachmentKeywordScanner = nullptr;
     MailCommon::FolderRequester *mFccFolder = nullptr;
     bool mPreventFccOverwrite = false;
     bool mCheckForForgottenAttachments = true;
@@ -660,6 +690,18 @@ private:
     KMailPluginEditorInitManagerInterface *mPluginEditorInitManagerInterface = nullptr;
     KMailPluginEditorConvertTextManagerInterface *mPluginEditorConvertTextManagerInterface = nullptr;
     KMailPluginGrammarEditorManagerInterface *mPluginEditorGrammarManagerInterface = nullptr;
+
+    // OpenPGP key lookups for recipients, batched by mailbox. Found keys are
+    // cached for the session, mailboxes without a key only for this window.
+    QSet<QString> mMailboxesWithoutKey;
+    QHash<QString, QVector<QPointer<MessageComposer::RecipientLineNG> > > mPendingKeyLookups;
+    QHash<QString, QVector<QPointer<MessageComposer::RecipientLineNG> > > mRunningKeyLookups;
+    std::vector<GpgME::Key> mFoundKeys;
+    QPointer<QGpgME::KeyListJob> mKeyListJob;
+    QTimer *mKeyLookupTimer = nullptr;
+    QTimer *mEncryptionStateTimer = nullptr;
+    int mPendingKeyLookupCount = 0;
+    int mSendBlockCount = 0;
 };
 
 #endif
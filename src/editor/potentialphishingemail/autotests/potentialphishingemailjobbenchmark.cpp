@@ -0,0 +1,75 @@
+/*
+  Copyright (c) 2026 KDE e.V.
+
+  This library is free software; you can redistribute it and/or modify it
+  under the terms of the GNU Library General Public License as published by
+  the Free Software Foundation; either version 2 of the License, or (at your
+  option) any later version.
+
+  This library is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+  License for more details.
+
+  You should have received a copy of the GNU Library General Public License
+  along with this library; see the file COPYING.LIB.  If not, write to the
+  Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+  02110-1301, USA.
+*/
+
+#include "potentialphishingemailjobbenchmark.h"
+#include "../potentialphishingemailjob.h"
+#include <QTest>
+
+namespace {
+const int numberOfAddresses = 10000;
+}
+
+PotentialPhishingEmailJobBenchmark::PotentialPhishingEmailJobBenchmark(QObject *parent)
+    : QObject(parent)
+{
+}
+
+PotentialPhishingEmailJobBenchmark::~PotentialPhishingEmailJobBenchmark()
+{
+}
+
+void PotentialPhishingEmailJobBenchmark::initTestCase()
+{
+    mAddresses.reserve(numberOfAddresses);
+    mWhiteList.reserve(numberOfAddresses);
+    for (int i = 0; i < numberOfAddresses; ++i) {
+        // Every other address looks like phishing, half of those are white listed
+        const QString address = (i % 2)
+                                ? QStringLiteral("\"user%1@kde.org\" <other%1@kde.org>").arg(i)
+                                : QStringLiteral("\"User %1\" <user%1@kde.org>").arg(i);
+        mAddresses.append(address);
+        mWhiteList.append((i % 4 == 1) ? address : QStringLiteral("\"unused%1@kde.org\" <unused%1@kde.org>").arg(i));
+    }
+}
+
+void PotentialPhishingEmailJobBenchmark::checkAddresses_data()
+{
+    QTest::addColumn<bool>("cc");
+    QTest::newRow("list") << false;
+    QTest::newRow("single field") << true;
+}
+
+void PotentialPhishingEmailJobBenchmark::checkAddresses()
+{
+    QFETCH(bool, cc);
+    // The composer passes To/Cc/Bcc as whole fields
+    const QStringList addresses = cc ? QStringList() << mAddresses.join(QStringLiteral(", ")) : mAddresses;
+    int found = 0;
+    QBENCHMARK {
+        PotentialPhishingEmailJob *job = new PotentialPhishingEmailJob;
+        job->setEmailWhiteList(mWhiteList);
+        job->setPotentialPhishingEmails(addresses);
+        job->start();
+        found = job->potentialPhisingEmails().count();
+        delete job;
+    }
+    QCOMPARE(found, numberOfAddresses / 4);
+}
+
+QTEST_GUILESS_MAIN(PotentialPhishingEmailJobBenchmark)
@@ -132,4 +132,15 @@ void PotentialPhishingEmailJobTest::shouldCreateCorrectListOfEmails()
     QCOMPARE(job->checkEmails(), createdListOfEmails);
 }
 
+void PotentialPhishingEmailJobTest::shouldNormalizeWhiteList()
+{
+    const QString email = QStringLiteral("\"bla@kde.org\" <foo@kde.org>");
+    PotentialPhishingEmailJob *job = new PotentialPhishingEmailJob;
+    job->setEmailWhiteList(QStringList() << (QLatin1String("  ") + email + QLatin1Char(' ')));
+    job->setPotentialPhishingEmails(QStringList() << email << QStringLiteral(" \"c@kde.org\" <dd@kde.org>, ") + email);
+    QVERIFY(job->start());
+    QCOMPARE(job->potentialPhisingEmails().count(), 1);
+    QCOMPARE(job->potentialPhisingEmails().at(0).trimmed(), QStringLiteral("\"c@kde.org\" <dd@kde.org>"));
+}
+
 QTEST_MAIN(PotentialPhishingEmailJobTest)
@@ -37,6 +37,7 @@ private Q_SLOTS:
     void shouldEmitSignal();
     void shouldCreateCorrectListOfEmails_data();
     void shouldCreateCorrectListOfEmails();
+    void shouldNormalizeWhiteList();
 };
 
 #endif // POTENTIALPHISHINGEMAILJOBTEST_H
@@ -18,6 +18,7 @@
 
 */
 #include "potentialphishingdetailwidget.h"
+#include "potentialphishingemailjob.h"
 
 #include <KConfigGroup>
 #include <QLabel>
@@ -76,5 +77,6 @@ void PotentialPhishingDetailWidget::save()
     }
     if (emailsAdded) {
         group.writeEntry("whiteList", potentialPhishing);
+        PotentialPhishingEmailJob::invalidateEmailWhiteList();
     }
 }
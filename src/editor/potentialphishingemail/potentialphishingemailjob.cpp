@@ -20,9 +20,29 @@
 
 #include "potentialphishingemailjob.h"
 #include <KEmailAddress>
+#include <KConfigGroup>
+#include <KSharedConfig>
 #include <PimCommon/PimUtil>
 #include "kmail_debug.h"
 
+namespace {
+struct WhiteListCache {
+    QSet<QString> emails;
+    bool loaded = false;
+};
+Q_GLOBAL_STATIC(WhiteListCache, s_whiteListCache)
+
+QSet<QString> normalizedWhiteList(const QStringList &emails)
+{
+    QSet<QString> whiteList;
+    whiteList.reserve(emails.count());
+    for (const QString &email : emails) {
+        whiteList.insert(email.trimmed());
+    }
+    return whiteList;
+}
+}
+
 PotentialPhishingEmailJob::PotentialPhishingEmailJob(QObject *parent)
     : QObject(parent)
 {
@@ -33,10 +53,31 @@ PotentialPhishingEmailJob::~PotentialPhishingEmailJob()
 }
 
 void PotentialPhishingEmailJob::setEmailWhiteList(const QStringList &emails)
+{
+    mEmailWhiteList = normalizedWhiteList(emails);
+}
+
+void PotentialPhishingEmailJob::setEmailWhiteList(const QSet<QString> &emails)
 {
     mEmailWhiteList = emails;
 }
 
+QSet<QString> PotentialPhishingEmailJob::emailWhiteList()
+{
+    if (!s_whiteListCache->loaded) {
+        KConfigGroup group(KSharedConfig::openConfig(), "PotentialPhishing");
+        s_whiteListCache->emails = normalizedWhiteList(group.readEntry("whiteList", QStringList()));
+        s_whiteListCache->loaded = true;
+    }
+    return s_whiteListCache->emails;
+}
+
+void PotentialPhishingEmailJob::invalidateEmailWhiteList()
+{
+    s_whiteListCache->emails.clear();
+    s_whiteListCache->loaded = false;
+}
+
 void PotentialPhishingEmailJob::setPotentialPhishingEmails(const QStringList &list)
 {
     mEmails = PimCommon::Util::generateEmailList(list);
@@ -61,39 +102,42 @@ bool PotentialPhishingEmailJob::start()
         return false;
     }
     for (const QString &addr : qAsConst(mEmails)) {
-        if (!mEmailWhiteList.contains(addr.trimmed())) {
-            QString tname, temail;
-            KEmailAddress::extractEmailAddressAndName(addr, temail, tname);    // ignore return value
-            // which is always false
-            if (tname.startsWith(QLatin1Char('@'))) { //Special case when name is just @foo <...> it mustn't recognize as a valid email
-                continue;
-            }
-            if (tname.contains(QLatin1Char('@'))) { //Potential address
-                if (tname.startsWith(QLatin1Char('<')) && tname.endsWith(QLatin1Char('>'))) {
-                    tname = tname.mid(1, tname.length() - 2);
-                }
-                if (tname.startsWith(QLatin1Char('\'')) && tname.endsWith(QLatin1Char('\''))) {
-                    tname = tname.mid(1, tname.length() - 2);
-                }
-                if (temail.toLower() != tname.toLower()) {
-                    const QString str = QStringLiteral("(%1)").arg(temail);
-                    if (!tname.contains(str, Qt::CaseInsensitive)) {
-                        const QStringList lst = tname.trimmed().split(QLatin1Char(' '));
-                        if (lst.count() > 1) {
-                            const QString firstName = lst.at(0);
-
-                            for (const QString &n : lst) {
-                                if (n != firstName) {
-                                    mPotentialPhisingEmails.append(addr);
-                                    break;
-                                }
-                            }
-                        } else {
-                            mPotentialPhisingEmails.append(addr);
-                        }
-                    }
+        if (mEmailWhiteList.contains(addr.trimmed())) {
+            continue;
+        }
+        QString tname, temail;
+        KEmailAddress::extractEmailAddressAndName(addr, temail, tname);    // ignore return value
+        // which is always false
+        if (tname.startsWith(QLatin1Char('@'))) { //Special case when name is just @foo <...> it mustn't recognize as a valid email
+            continue;
+        }
+        if (!tname.contains(QLatin1Char('@'))) { //Not a potential address
+            continue;
+        }
+        QStringRef name(&tname);
+        if (name.startsWith(QLatin1Char('<')) && name.endsWith(QLatin1Char('>'))) {
+            name = name.mid(1, name.length() - 2);
+        }
+        if (name.startsWith(QLatin1Char('\'')) && name.endsWith(QLatin1Char('\''))) {
+            name = name.mid(1, name.length() - 2);
+        }
+        if (name.compare(temail, Qt::CaseInsensitive) == 0) {
+            continue;
+        }
+        if (name.contains(QLatin1Char('(') + temail + QLatin1Char(')'), Qt::CaseInsensitive)) {
+            continue;
+        }
+        const QVector<QStringRef> lst = name.trimmed().split(QLatin1Char(' '));
+        if (lst.count() > 1) {
+            const QStringRef firstName = lst.at(0);
+            for (const QStringRef &n : lst) {
+                if (n != firstName) {
+                    mPotentialPhisingEmails.append(addr);
+                    break;
                 }
             }
+        } else {
+            mPotentialPhisingEmails.append(addr);
         }
     }
     Q_EMIT potentialPhishingEmailsFound(mPotentialPhisingEmails);
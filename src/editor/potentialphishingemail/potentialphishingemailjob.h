@@ -22,6 +22,7 @@
 #define POTENTIALPHISHINGEMAILJOB_H
 
 #include <QObject>
+#include <QSet>
 #include <QStringList>
 
 class PotentialPhishingEmailJob : public QObject
@@ -32,6 +33,7 @@ public:
     ~PotentialPhishingEmailJob();
 
     void setEmailWhiteList(const QStringList &emails);
+    void setEmailWhiteList(const QSet<QString> &emails);
     void setPotentialPhishingEmails(const QStringList &emails);
 
     QStringList potentialPhisingEmails() const;
@@ -39,6 +41,13 @@ public:
 
     QStringList checkEmails() const;
 
+    /**
+     * Returns the white list stored in the "PotentialPhishing" config group,
+     * trimmed. It is read once and kept until invalidateEmailWhiteList().
+     */
+    static QSet<QString> emailWhiteList();
+    static void invalidateEmailWhiteList();
+
 Q_SIGNALS:
     void potentialPhishingEmailsFound(const QStringList &emails);
 
@@ -46,7 +55,7 @@ private:
     Q_DISABLE_COPY(PotentialPhishingEmailJob)
     QStringList mEmails;
     QStringList mPotentialPhisingEmails;
-    QStringList mEmailWhiteList;
+    QSet<QString> mEmailWhiteList;
 };
 
 #endif // POTENTIALPHISHINGEMAILJOB_H
@@ -0,0 +1,354 @@
+/*
+   Copyright (C) 2026 KDE e.V.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "folderexpiryscheduler.h"
+#include "kmkernel.h"
+#include "kmail_debug.h"
+#include "settings/kmailsettings.h"
+#include "libkdepim/progressmanager.h"
+
+#include <MailCommon/ExpireCollectionAttribute>
+#include <MailCommon/MailKernel>
+#include <MailCommon/MailUtil>
+
+#include <AkonadiCore/ItemDeleteJob>
+#include <AkonadiCore/ItemFetchJob>
+#include <AkonadiCore/ItemFetchScope>
+#include <AkonadiCore/ItemMoveJob>
+#include <AkonadiCore/Monitor>
+#include <Akonadi/KMime/MessageFlags>
+#include <Akonadi/KMime/MessageParts>
+#include <Akonadi/KMime/MessageStatus>
+#include <KMime/Message>
+#include <KConfigGroup>
+#include <KLocalizedString>
+
+#include <QDateTime>
+
+using namespace KMail;
+
+namespace {
+static const int sRemoveChunkSize = 100;
+static const qint64 sSecondsPerDay = 24 * 60 * 60;
+}
+
+FolderExpiryScheduler::FolderExpiryScheduler(QObject *parent)
+    : QObject(parent)
+{
+    loadDeadlines();
+    Akonadi::Monitor *monitor = KMKernel::self()->folderCollectionMonitor();
+    connect(monitor, &Akonadi::Monitor::itemAdded, this, &FolderExpiryScheduler::slotItemAdded);
+    connect(monitor, &Akonadi::Monitor::itemsFlagsChanged, this, &FolderExpiryScheduler::slotItemsFlagsChanged);
+    connect(monitor, &Akonadi::Monitor::collectionRemoved, this, &FolderExpiryScheduler::slotCollectionRemoved);
+    connect(monitor, qOverload<const Akonadi::Collection &, const QSet<QByteArray> &>(&Akonadi::Monitor::collectionChanged),
+            this, &FolderExpiryScheduler::slotCollectionChanged);
+}
+
+FolderExpiryScheduler::~FolderExpiryScheduler()
+{
+    saveDeadlines();
+}
+
+void FolderExpiryScheduler::expireFolders(const Akonadi::Collection::List &collections, bool force)
+{
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    for (const Akonadi::Collection &collection : collections) {
+        const Akonadi::Collection::Id id = collection.id();
+        if (!collection.isValid() || mQueue.contains(id)) {
+            continue;
+        }
+        if (force) {
+            mForcedFolders.insert(id);
+        } else {
+            // Skip the folders which have nothing to expire yet without
+            // even looking at their settings.
+            const auto it = mDeadlines.constFind(id);
+            if (it != mDeadlines.cend() && (it->time < 0 || it->time > now)) {
+                continue;
+            }
+        }
+        mQueue.append(id);
+    }
+    if (!mRunning) {
+        processNextFolder();
+    }
+}
+
+void FolderExpiryScheduler::processNextFolder()
+{
+    mExpirableItems.clear();
+    while (!mQueue.isEmpty()) {
+        const Akonadi::Collection::Id id = mQueue.takeFirst();
+        const bool force = mForcedFolders.remove(id);
+        const Akonadi::Collection collection = CommonKernel->collectionFromId(id);
+        if (!collection.isValid()) {
+            continue;
+        }
+
+        bool mustDeleteExpirationAttribute = false;
+        MailCommon::ExpireCollectionAttribute *attr = MailCommon::Util::expirationCollectionAttribute(collection, mustDeleteExpirationAttribute);
+        int unreadDays = -1;
+        int readDays = -1;
+        bool moveToFolder = false;
+        Akonadi::Collection::Id targetId = -1;
+        if (attr->isAutoExpire()) {
+            attr->daysToExpire(unreadDays, readDays);
+            moveToFolder = attr->expireAction() == MailCommon::ExpireCollectionAttribute::ExpireMove;
+            targetId = attr->expireToFolderId();
+        }
+        if (mustDeleteExpirationAttribute) {
+            delete attr;
+        }
+
+        if (unreadDays < 0 && readDays < 0) {
+            if (mDeadlines.remove(id) > 0) {
+                mDeadlinesChanged = true;
+            }
+            continue;
+        }
+
+        const auto it = mDeadlines.constFind(id);
+        if (!force && it != mDeadlines.cend()
+            && it->unreadDays == unreadDays && it->readDays == readDays
+            && (it->time < 0 || it->time > QDateTime::currentSecsSinceEpoch())) {
+            continue;
+        }
+
+        mTargetFolder = Akonadi::Collection();
+        if (moveToFolder) {
+            mTargetFolder = CommonKernel->collectionFromId(targetId);
+            if (!mTargetFolder.isValid() || mTargetFolder.id() == id) {
+                qCDebug(KMAIL_LOG) << "Expiry target folder of" << id << "is not valid";
+                continue;
+            }
+        }
+
+        mRunning = true;
+        mCurrentFolder = collection;
+        mUnreadDays = unreadDays;
+        mReadDays = readDays;
+        mCutoffTime = QDateTime::currentSecsSinceEpoch();
+        mNextDeadline = -1;
+        mExcludeImportant = KMailSettings::self()->excludeImportantMailFromExpiry();
+
+        if (!mProgressItem) {
+            mProgressItem = KPIM::ProgressManager::createProgressItem(i18n("Expiring old messages"));
+            mProgressItem->setUsesBusyIndicator(true);
+            mProgressItem->setCryptoStatus(KPIM::ProgressItem::Unknown);
+        }
+        mProgressItem->setStatus(collection.displayName());
+
+        // The envelope is enough to know the date of a message, and the
+        // items don't need to be kept by the job once they were looked at.
+        Akonadi::ItemFetchJob *job = new Akonadi::ItemFetchJob(collection, this);
+        job->setDeliveryOption(Akonadi::ItemFetchJob::EmitItemsInBatches);
+        job->fetchScope().fetchPayloadPart(Akonadi::MessagePart::Envelope);
+        job->fetchScope().setFetchModificationTime(false);
+        connect(job, &Akonadi::ItemFetchJob::itemsReceived, this, &FolderExpiryScheduler::slotItemsReceived);
+        connect(job, &Akonadi::ItemFetchJob::result, this, &FolderExpiryScheduler::slotFetchDone);
+        return;
+    }
+
+    mRunning = false;
+    if (mProgressItem) {
+        mProgressItem->setComplete();
+        mProgressItem = nullptr;
+    }
+    if (mExpiredItems > 0) {
+        qCDebug(KMAIL_LOG) << "Expired" << mExpiredItems << "messages";
+        mExpiredItems = 0;
+    }
+    saveDeadlines();
+}
+
+void FolderExpiryScheduler::slotItemsReceived(const Akonadi::Item::List &items)
+{
+    for (const Akonadi::Item &item : items) {
+        if (!item.hasPayload<KMime::Message::Ptr>()) {
+            continue;
+        }
+        const KMime::Message::Ptr msg = item.payload<KMime::Message::Ptr>();
+        const KMime::Headers::Date *date = msg->date(false);
+        if (!date || !date->dateTime().isValid()) {
+            continue;
+        }
+        Akonadi::MessageStatus status;
+        status.setStatusFromFlags(item.flags());
+        if (mExcludeImportant && (status.isImportant() || status.isToAct())) {
+            continue;
+        }
+        const int days = status.isRead() ? mReadDays : mUnreadDays;
+        if (days < 0) {
+            continue;
+        }
+        const qint64 expiryTime = date->dateTime().toSecsSinceEpoch() + days * sSecondsPerDay;
+        if (expiryTime <= mCutoffTime) {
+            mExpirableItems.append(Akonadi::Item(item.id()));
+        } else if (mNextDeadline < 0 || expiryTime < mNextDeadline) {
+            mNextDeadline = expiryTime;
+        }
+    }
+}
+
+void FolderExpiryScheduler::slotFetchDone(KJob *job)
+{
+    if (job->error()) {
+        qCDebug(KMAIL_LOG) << "Unable to fetch messages of" << mCurrentFolder.id() << job->errorString();
+        processNextFolder();
+        return;
+    }
+    removeNextItems();
+}
+
+void FolderExpiryScheduler::removeNextItems()
+{
+    if (mExpirableItems.isEmpty()) {
+        folderDone();
+        return;
+    }
+    const int count = qMin(sRemoveChunkSize, mExpirableItems.count());
+    const Akonadi::Item::List chunk = mExpirableItems.mid(0, count);
+    mExpirableItems.erase(mExpirableItems.begin(), mExpirableItems.begin() + count);
+
+    KJob *job = nullptr;
+    if (mTargetFolder.isValid()) {
+        job = new Akonadi::ItemMoveJob(chunk, mTargetFolder, this);
+    } else {
+        job = new Akonadi::ItemDeleteJob(chunk, this);
+    }
+    job->setProperty("itemCount", count);
+    connect(job, &KJob::result, this, &FolderExpiryScheduler::slotRemoveDone);
+}
+
+void FolderExpiryScheduler::slotRemoveDone(KJob *job)
+{
+    if (job->error()) {
+        // Keep the folder due, so that it is looked at again next time.
+        qCDebug(KMAIL_LOG) << "Unable to expire messages of" << mCurrentFolder.id() << job->errorString();
+        if (mDeadlines.remove(mCurrentFolder.id()) > 0) {
+            mDeadlinesChanged = true;
+        }
+        processNextFolder();
+        return;
+    }
+    mExpiredItems += job->property("itemCount").toInt();
+    removeNextItems();
+}
+
+void FolderExpiryScheduler::folderDone()
+{
+    const Deadline deadline = { mNextDeadline, mUnreadDays, mReadDays };
+    mDeadlines.insert(mCurrentFolder.id(), deadline);
+    mDeadlinesChanged = true;
+    processNextFolder();
+}
+
+void FolderExpiryScheduler::invalidateDeadline(Akonadi::Collection::Id id)
+{
+    if (mDeadlines.remove(id) > 0) {
+        mDeadlinesChanged = true;
+    }
+}
+
+void FolderExpiryScheduler::slotItemAdded(const Akonadi::Item &item, const Akonadi::Collection &collection)
+{
+    auto it = mDeadlines.find(collection.id());
+    if (it == mDeadlines.end()) {
+        return;
+    }
+    // New mail is usually younger than what the folder already contains,
+    // but imported or moved messages may expire earlier.
+    if (item.hasPayload<KMime::Message::Ptr>()) {
+        const KMime::Headers::Date *date = item.payload<KMime::Message::Ptr>()->date(false);
+        const int days = it->unreadDays >= 0 && (it->readDays < 0 || it->unreadDays < it->readDays) ? it->unreadDays : it->readDays;
+        if (date && date->dateTime().isValid()) {
+            const qint64 expiryTime = date->dateTime().toSecsSinceEpoch() + days * sSecondsPerDay;
+            if (it->time < 0 || expiryTime < it->time) {
+                it->time = expiryTime;
+                mDeadlinesChanged = true;
+            }
+            return;
+        }
+    }
+    invalidateDeadline(collection.id());
+}
+
+void FolderExpiryScheduler::slotItemsFlagsChanged(const Akonadi::Item::List &items, const QSet<QByteArray> &addedFlags, const QSet<QByteArray> &removedFlags)
+{
+    // A message marked as read may expire earlier than when it was unread,
+    // and an important message may become expirable when it loses that flag.
+    const bool markedAsRead = addedFlags.contains(Akonadi::MessageFlags::Seen);
+    const bool lostImportant = removedFlags.contains(Akonadi::MessageFlags::Flagged)
+                               || removedFlags.contains(Akonadi::MessageFlags::ToAct);
+    if (!markedAsRead && !lostImportant) {
+        return;
+    }
+    for (const Akonadi::Item &item : items) {
+        const Akonadi::Collection::Id id = item.parentCollection().id();
+        const auto it = mDeadlines.constFind(id);
+        if (it == mDeadlines.cend()) {
+            continue;
+        }
+        if (lostImportant
+            || (it->readDays >= 0 && (it->unreadDays < 0 || it->readDays < it->unreadDays))) {
+            invalidateDeadline(id);
+        }
+    }
+}
+
+void FolderExpiryScheduler::slotCollectionRemoved(const Akonadi::Collection &collection)
+{
+    invalidateDeadline(collection.id());
+}
+
+void FolderExpiryScheduler::slotCollectionChanged(const Akonadi::Collection &collection, const QSet<QByteArray> &changedAttributes)
+{
+    // The expiry settings of the folder were changed
+    if (changedAttributes.contains(MailCommon::ExpireCollectionAttribute().type())) {
+        invalidateDeadline(collection.id());
+    }
+}
+
+void FolderExpiryScheduler::loadDeadlines()
+{
+    const KConfigGroup group(KMKernel::self()->config(), "FolderExpiry");
+    const QStringList keys = group.keyList();
+    for (const QString &key : keys) {
+        const QList<qint64> values = group.readEntry(key, QList<qint64>());
+        if (values.count() != 3) {
+            continue;
+        }
+        const Deadline deadline = { values.at(0), int(values.at(1)), int(values.at(2)) };
+        mDeadlines.insert(key.toLongLong(), deadline);
+    }
+}
+
+void FolderExpiryScheduler::saveDeadlines()
+{
+    if (!mDeadlinesChanged) {
+        return;
+    }
+    KConfigGroup group(KMKernel::self()->config(), "FolderExpiry");
+    group.deleteGroup();
+    for (auto it = mDeadlines.cbegin(), end = mDeadlines.cend(); it != end; ++it) {
+        group.writeEntry(QString::number(it.key()), QList<qint64>() << it->time << it->unreadDays << it->readDays);
+    }
+    group.sync();
+    mDeadlinesChanged = false;
+}
@@ -0,0 +1,98 @@
+/*
+   Copyright (C) 2026 KDE e.V.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef FOLDEREXPIRYSCHEDULER_H
+#define FOLDEREXPIRYSCHEDULER_H
+
+#include <QObject>
+#include <QHash>
+#include <QPointer>
+#include <QSet>
+#include <QVector>
+#include <AkonadiCore/Collection>
+#include <AkonadiCore/Item>
+
+class KJob;
+namespace KPIM {
+class ProgressItem;
+}
+namespace KMail {
+/**
+ * Expires old messages of the folders which have expiry settings.
+ *
+ * For every folder the time at which its next message becomes expirable is
+ * remembered, and scheduled runs only look at folders whose deadline has
+ * passed. The deadlines are stored in the "FolderExpiry" config group, and
+ * invalidated when a message is added or marked as read in a way that can
+ * make it expire earlier.
+ */
+class FolderExpiryScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FolderExpiryScheduler(QObject *parent = nullptr);
+    ~FolderExpiryScheduler();
+
+    /**
+     * Expires the given folders. Unless @p force is true, folders whose
+     * next deadline is still in the future are skipped.
+     */
+    void expireFolders(const Akonadi::Collection::List &collections, bool force);
+
+private:
+    Q_DISABLE_COPY(FolderExpiryScheduler)
+    struct Deadline {
+        qint64 time; // seconds since epoch, -1 when nothing can expire
+        int unreadDays;
+        int readDays;
+    };
+
+    void processNextFolder();
+    void slotItemsReceived(const Akonadi::Item::List &items);
+    void slotFetchDone(KJob *job);
+    void removeNextItems();
+    void slotRemoveDone(KJob *job);
+    void folderDone();
+    void slotItemAdded(const Akonadi::Item &item, const Akonadi::Collection &collection);
+    void slotItemsFlagsChanged(const Akonadi::Item::List &items, const QSet<QByteArray> &addedFlags, const QSet<QByteArray> &removedFlags);
+    void slotCollectionRemoved(const Akonadi::Collection &collection);
+    void slotCollectionChanged(const Akonadi::Collection &collection, const QSet<QByteArray> &changedAttributes);
+    void invalidateDeadline(Akonadi::Collection::Id id);
+    void loadDeadlines();
+    void saveDeadlines();
+
+    QHash<Akonadi::Collection::Id, Deadline> mDeadlines;
+    QVector<Akonadi::Collection::Id> mQueue;
+    QSet<Akonadi::Collection::Id> mForcedFolders;
+    Akonadi::Collection mCurrentFolder;
+    Akonadi::Collection mTargetFolder;
+    Akonadi::Item::List mExpirableItems;
+    QPointer<KPIM::ProgressItem> mProgressItem;
+    qint64 mCutoffTime = 0;
+    qint64 mNextDeadline = -1;
+    int mUnreadDays = -1;
+    int mReadDays = -1;
+    int mExpiredItems = 0;
+    bool mExcludeImportant = false;
+    bool mRunning = false;
+    bool mDeadlinesChanged = false;
+};
+}
+
+#endif // FOLDEREXPIRYSCHEDULER_H
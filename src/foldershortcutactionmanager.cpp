@@ -28,9 +28,12 @@
 
 #include <QAction>
 #include <KActionCollection>
+#include <KConfigGroup>
 #include <KLocalizedString>
 #include <QIcon>
 
+#include <algorithm>
+
 using namespace KMail;
 using namespace MailCommon;
 
@@ -69,6 +72,8 @@ FolderShortcutActionManager::FolderShortcutActionManager(QWidget *parent, KActio
 
 void FolderShortcutActionManager::createActions()
 {
+    loadShortcutIndex();
+
     // When this function is called, the ETM has not finished loading yet. Therefore, when new
     // rows are inserted in the ETM, see if we have new collections that we can assign shortcuts
     // to.
@@ -78,12 +83,62 @@ void FolderShortcutActionManager::createActions()
     connect(KernelIf->folderCollectionMonitor(), &Akonadi::Monitor::collectionRemoved,
             this, &FolderShortcutActionManager::slotCollectionRemoved, Qt::UniqueConnection);
 
+    mPendingCollections = mShortcutCollections;
+    for (auto it = mFolderShortcutCommands.cbegin(), end = mFolderShortcutCommands.cend(); it != end; ++it) {
+        mPendingCollections.remove(it.key());
+    }
+
     const int rowCount(model->rowCount());
     if (rowCount > 0) {
         updateShortcutsForIndex(QModelIndex(), 0, rowCount - 1);
     }
 }
 
+void FolderShortcutActionManager::loadShortcutIndex()
+{
+    if (mShortcutIndexLoaded) {
+        return;
+    }
+    mShortcutIndexLoaded = true;
+
+    KConfigGroup group(KernelIf->config(), "FolderShortcuts");
+    if (group.hasKey("Collections")) {
+        const QList<qint64> ids = group.readEntry("Collections", QList<qint64>());
+        for (qint64 id : ids) {
+            mShortcutCollections.insert(id);
+        }
+        return;
+    }
+
+    // No index yet: build it once from the folder settings groups.
+    const QString prefix = QStringLiteral("Folder-");
+    const QStringList groups = KernelIf->config()->groupList();
+    for (const QString &groupName : groups) {
+        if (!groupName.startsWith(prefix)) {
+            continue;
+        }
+        bool ok = false;
+        const Akonadi::Collection::Id id = groupName.midRef(prefix.length()).toLongLong(&ok);
+        if (ok && !KConfigGroup(KernelIf->config(), groupName).readEntry("Shortcut", QString()).isEmpty()) {
+            mShortcutCollections.insert(id);
+        }
+    }
+    saveShortcutIndex();
+}
+
+void FolderShortcutActionManager::saveShortcutIndex()
+{
+    QList<qint64> ids;
+    ids.reserve(mShortcutCollections.count());
+    for (Akonadi::Collection::Id id : qAsConst(mShortcutCollections)) {
+        ids.append(id);
+    }
+    std::sort(ids.begin(), ids.end());
+    KConfigGroup group(KernelIf->config(), "FolderShortcuts");
+    group.writeEntry("Collections", ids);
+    group.sync();
+}
+
 void FolderShortcutActionManager::slotRowsInserted(const QModelIndex &parent, int start, int end)
 {
     updateShortcutsForIndex(parent, start, end);
@@ -91,14 +146,23 @@ void FolderShortcutActionManager::slotRowsInserted(const QModelIndex &parent, in
 
 void FolderShortcutActionManager::updateShortcutsForIndex(const QModelIndex &parent, int start, int end)
 {
+    // Only the collections of the index are looked at, and only until all
+    // of them got their action.
+    if (mPendingCollections.isEmpty()) {
+        return;
+    }
     QAbstractItemModel *model = KernelIf->collectionModel();
-    for (int i = start; i <= end; ++i) {
+    for (int i = start; i <= end && !mPendingCollections.isEmpty(); ++i) {
         if (model->hasIndex(i, 0, parent)) {
             const QModelIndex child = model->index(i, 0, parent);
-            Akonadi::Collection collection
-                = model->data(child, Akonadi::EntityTreeModel::CollectionRole).value<Akonadi::Collection>();
-            if (collection.isValid()) {
-                shortcutChanged(collection);
+            const Akonadi::Collection::Id id = model->data(child, Akonadi::EntityTreeModel::CollectionIdRole).toLongLong();
+            if (mPendingCollections.remove(id)) {
+                const Akonadi::Collection collection
+                    = model->data(child, Akonadi::EntityTreeModel::CollectionRole).value<Akonadi::Collection>();
+                if (collection.isValid()) {
+                    const QSharedPointer<FolderSettings> folderCollection(FolderSettings::forCollection(collection, false));
+                    createShortcutAction(collection, QKeySequence(folderCollection->shortcut()));
+                }
             }
             if (model->rowCount(child) > 0) {
                 updateShortcutsForIndex(child, 0, model->rowCount(child) - 1);
@@ -110,14 +174,36 @@ void FolderShortcutActionManager::updateShortcutsForIndex(const QModelIndex &par
 void FolderShortcutActionManager::slotCollectionRemoved(const Akonadi::Collection &col)
 {
     delete mFolderShortcutCommands.take(col.id());
+    mPendingCollections.remove(col.id());
+    if (mShortcutCollections.remove(col.id())) {
+        saveShortcutIndex();
+    }
 }
 
 void FolderShortcutActionManager::shortcutChanged(const Akonadi::Collection &col)
 {
+    loadShortcutIndex();
+
     // remove the old one, no autodelete in Qt4
-    slotCollectionRemoved(col);
+    delete mFolderShortcutCommands.take(col.id());
+    mPendingCollections.remove(col.id());
     const QSharedPointer<FolderSettings> folderCollection(FolderSettings::forCollection(col, false));
     const QKeySequence shortcut(folderCollection->shortcut());
+    if (shortcut.isEmpty()) {
+        if (mShortcutCollections.remove(col.id())) {
+            saveShortcutIndex();
+        }
+        return;
+    }
+    if (!mShortcutCollections.contains(col.id())) {
+        mShortcutCollections.insert(col.id());
+        saveShortcutIndex();
+    }
+    createShortcutAction(col, shortcut);
+}
+
+void FolderShortcutActionManager::createShortcutAction(const Akonadi::Collection &col, const QKeySequence &shortcut)
+{
     if (shortcut.isEmpty()) {
         return;
     }
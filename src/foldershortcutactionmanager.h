@@ -26,6 +26,7 @@
 #include <QHash>
 #include <QModelIndex>
 #include <QObject>
+#include <QSet>
 
 class QAction;
 
@@ -84,7 +85,14 @@ private:
 private:
     Q_DISABLE_COPY(FolderShortcutActionManager)
     void updateShortcutsForIndex(const QModelIndex &parent, int start, int end);
+    void createShortcutAction(const Akonadi::Collection &col, const QKeySequence &shortcut);
+    void loadShortcutIndex();
+    void saveShortcutIndex();
     QHash< Akonadi::Collection::Id, FolderShortcutCommand * > mFolderShortcutCommands;
+    // Collections which have a shortcut, and those of them without action yet.
+    QSet<Akonadi::Collection::Id> mShortcutCollections;
+    QSet<Akonadi::Collection::Id> mPendingCollections;
+    bool mShortcutIndexLoaded = false;
     KActionCollection *mActionCollection = nullptr;
     QWidget *mParent = nullptr;
 };
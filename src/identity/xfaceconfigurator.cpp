@@ -54,11 +54,48 @@
 #include <QFontDatabase>
 #include <QImageReader>
 #include <QFileDialog>
+#include <QCache>
+#include <QCryptographicHash>
+#include <QFutureWatcher>
+#include <QMutex>
+#include <QProgressBar>
+#include <QtConcurrent>
+
+#include <functional>
+
 using namespace KContacts;
 using namespace KIO;
 using namespace KMail;
 using namespace MessageViewer;
 
+namespace {
+// X-Faces already computed, keyed by a hash of the source image
+struct XFaceCache {
+    QMutex mutex;
+    QCache<QByteArray, QString> faces{32};
+};
+Q_GLOBAL_STATIC(XFaceCache, sXFaceCache)
+
+QString cachedXFace(const QByteArray &key, const std::function<QImage()> &loadImage)
+{
+    {
+        QMutexLocker locker(&sXFaceCache->mutex);
+        if (const QString *face = sXFaceCache->faces.object(key)) {
+            return *face;
+        }
+    }
+    const QImage image = loadImage();
+    if (image.isNull()) {
+        return QString();
+    }
+    KXFace xf;
+    const QString face = xf.fromImage(image);
+    QMutexLocker locker(&sXFaceCache->mutex);
+    sXFaceCache->faces.insert(key, new QString(face));
+    return face;
+}
+}
+
 using namespace KMail;
 XFaceConfigurator::XFaceConfigurator(QWidget *parent)
     : QWidget(parent)
@@ -125,7 +162,7 @@ XFaceConfigurator::XFaceConfigurator(QWidget *parent)
     page_vlay->setContentsMargins(0, 0, 0, 0);
     hlay = new QHBoxLayout(); // inherits spacing ??? FIXME really?
     page_vlay->addLayout(hlay);
-    QPushButton *mFromFileBtn = new QPushButton(i18n("Select File..."), page);
+    mFromFileBtn = new QPushButton(i18n("Select File..."), page);
     mFromFileBtn->setWhatsThis(
         i18n("Use this to select an image file to create the picture from. "
              "The image should be of high contrast and nearly quadratic shape. "
@@ -133,13 +170,28 @@ XFaceConfigurator::XFaceConfigurator(QWidget *parent)
     mFromFileBtn->setAutoDefault(false);
     page_vlay->addWidget(mFromFileBtn, 1);
     connect(mFromFileBtn, &QPushButton::released, this, &XFaceConfigurator::slotSelectFile);
-    QPushButton *mFromAddrbkBtn = new QPushButton(i18n("Set From Address Book"), page);
+    mFromAddrbkBtn = new QPushButton(i18n("Set From Address Book"), page);
     mFromAddrbkBtn->setWhatsThis(
         i18n("You can use a scaled-down version of the picture "
              "you have set in your address book entry."));
     mFromAddrbkBtn->setAutoDefault(false);
     page_vlay->addWidget(mFromAddrbkBtn, 1);
     connect(mFromAddrbkBtn, &QPushButton::released, this, &XFaceConfigurator::slotSelectFromAddressbook);
+
+    // shown while a picture is downloaded and converted
+    mImportWidget = new QWidget(page);
+    QHBoxLayout *importLayout = new QHBoxLayout(mImportWidget);
+    importLayout->setContentsMargins(0, 0, 0, 0);
+    importLayout->addWidget(new QLabel(i18n("Importing picture..."), mImportWidget));
+    QProgressBar *importProgress = new QProgressBar(mImportWidget);
+    importProgress->setRange(0, 0);
+    importLayout->addWidget(importProgress, 1);
+    QPushButton *cancelImportBtn = new QPushButton(i18n("Cancel"), mImportWidget);
+    cancelImportBtn->setAutoDefault(false);
+    importLayout->addWidget(cancelImportBtn);
+    connect(cancelImportBtn, &QPushButton::clicked, this, &XFaceConfigurator::slotCancelImport);
+    mImportWidget->hide();
+    page_vlay->addWidget(mImportWidget);
     QLabel *label1 = new QLabel(i18n("<qt>KMail can send a small (48x48 pixels), low-quality, "
                                      "monochrome picture with every message. "
                                      "For example, this could be a picture of you or a glyph. "
@@ -176,6 +228,7 @@ XFaceConfigurator::XFaceConfigurator(QWidget *parent)
 
 XFaceConfigurator::~XFaceConfigurator()
 {
+    slotCancelImport();
 }
 
 bool XFaceConfigurator::isXFaceEnabled() const
@@ -198,16 +251,94 @@ void XFaceConfigurator::setXFace(const QString &text)
     mTextEdit->editor()->setPlainText(text);
 }
 
+QString XFaceConfigurator::xfaceFromImageData(const QByteArray &data)
+{
+    return cachedXFace(QCryptographicHash::hash(data, QCryptographicHash::Sha1), [data]() {
+        return QImage::fromData(data);
+    });
+}
+
+QString XFaceConfigurator::xfaceFromImage(const QImage &image)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArray::number(image.width()) + 'x' + QByteArray::number(image.height()) + '@' + QByteArray::number(image.format()));
+    hash.addData(reinterpret_cast<const char *>(image.constBits()), image.sizeInBytes());
+    return cachedXFace(hash.result(), [image]() {
+        return image;
+    });
+}
+
 void XFaceConfigurator::setXfaceFromFile(const QUrl &url)
 {
-    auto job = KIO::storedGet(url);
-    KJobWidgets::setWindow(job, this);
-    if (job->exec()) {
-        KXFace xf;
-        mTextEdit->editor()->setPlainText(xf.fromImage(QImage::fromData(job->data())));
-    } else {
+    slotCancelImport();
+    mImageJob = KIO::storedGet(url, KIO::NoReload, KIO::HideProgressInfo);
+    KJobWidgets::setWindow(mImageJob, this);
+    connect(mImageJob.data(), &KJob::result, this, &XFaceConfigurator::slotImageDownloaded);
+    setImportInProgress(true);
+}
+
+void XFaceConfigurator::slotImageDownloaded(KJob *job)
+{
+    mImageJob = nullptr;
+    if (job->error()) {
+        setImportInProgress(false);
         KMessageBox::error(this, job->errorString());
+        return;
+    }
+    const QByteArray data = static_cast<KIO::StoredTransferJob *>(job)->data();
+    startConversion(QtConcurrent::run(&XFaceConfigurator::xfaceFromImageData, data));
+}
+
+void XFaceConfigurator::setXfaceFromImage(const QImage &image)
+{
+    slotCancelImport();
+    setImportInProgress(true);
+    startConversion(QtConcurrent::run(&XFaceConfigurator::xfaceFromImage, image));
+}
+
+void XFaceConfigurator::startConversion(const QFuture<QString> &future)
+{
+    mConversionWatcher = new QFutureWatcher<QString>(this);
+    connect(mConversionWatcher, &QFutureWatcherBase::finished, this, &XFaceConfigurator::slotConversionFinished);
+    mConversionWatcher->setFuture(future);
+}
+
+void XFaceConfigurator::slotConversionFinished()
+{
+    const QString face = mConversionWatcher->result();
+    mConversionWatcher->deleteLater();
+    mConversionWatcher = nullptr;
+    setImportInProgress(false);
+    if (face.isEmpty()) {
+        KMessageBox::error(this, i18n("The selected picture could not be read."));
+        return;
+    }
+    mTextEdit->editor()->setPlainText(face);
+}
+
+void XFaceConfigurator::slotCancelImport()
+{
+    if (mImageJob) {
+        mImageJob->kill();
+        mImageJob = nullptr;
+    }
+    if (mConversionWatcher) {
+        // The conversion can't be interrupted, its result is simply dropped
+        mConversionWatcher->disconnect(this);
+        mConversionWatcher->deleteLater();
+        mConversionWatcher = nullptr;
+    }
+    setImportInProgress(false);
+}
+
+void XFaceConfigurator::setImportInProgress(bool inProgress)
+{
+    if (!mImportWidget) {
+        return;
     }
+    mImportWidget->setVisible(inProgress);
+    mFromFileBtn->setEnabled(!inProgress);
+    mFromAddrbkBtn->setEnabled(!inProgress);
 }
 
 void XFaceConfigurator::slotSelectFile()
@@ -255,8 +386,7 @@ void XFaceConfigurator::slotDelayedSelectFromAddressbook(KJob *job)
     if (contact.photo().isIntern()) {
         const QImage photo = contact.photo().data();
         if (!photo.isNull()) {
-            KXFace xf;
-            mTextEdit->editor()->setPlainText(xf.fromImage(photo));
+            setXfaceFromImage(photo);
         } else {
             KMessageBox::information(this, i18n("No picture set for your address book entry."), i18n("No Picture"));
         }
@@ -18,12 +18,20 @@
 #define KMAIL_XFACECONFIGURATOR_H
 
 #include <QWidget>
+#include <QPointer>
 
 class KJob;
 class QUrl;
+class QImage;
 
 class QCheckBox;
 class QLabel;
+class QPushButton;
+template<typename T> class QFuture;
+template<typename T> class QFutureWatcher;
+namespace KIO {
+class StoredTransferJob;
+}
 namespace KPIMTextEdit {
 class PlainTextEditorWidget;
 }
@@ -41,17 +49,31 @@ public:
     QString xface() const;
     void setXFace(const QString &text);
 
+    static QString xfaceFromImageData(const QByteArray &data);
+    static QString xfaceFromImage(const QImage &image);
+
 private:
     void setXfaceFromFile(const QUrl &url);
+    void setXfaceFromImage(const QImage &image);
+    void startConversion(const QFuture<QString> &future);
+    void setImportInProgress(bool inProgress);
 
     void slotSelectFile();
     void slotSelectFromAddressbook();
     void slotDelayedSelectFromAddressbook(KJob *);
+    void slotImageDownloaded(KJob *job);
+    void slotConversionFinished();
+    void slotCancelImport();
     void slotUpdateXFace();
 
     QCheckBox *mEnableCheck = nullptr;
     KPIMTextEdit::PlainTextEditorWidget *mTextEdit = nullptr;
     QLabel *mXFaceLabel = nullptr;
+    QPushButton *mFromFileBtn = nullptr;
+    QPushButton *mFromAddrbkBtn = nullptr;
+    QWidget *mImportWidget = nullptr;
+    QPointer<KIO::StoredTransferJob> mImageJob;
+    QFutureWatcher<QString> *mConversionWatcher = nullptr;
 };
 } // namespace KMail
 
@@ -0,0 +1,161 @@
+/*
+   Copyright (C) 2026 KDE e.V.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "checkfolderfromresourcesjob.h"
+#include "kmail_debug.h"
+#include "imapresourcesettings.h"
+#include "pop3settings.h"
+#include "mailcommon/mailutil.h"
+#include "MailCommon/MailKernel"
+#include "PimCommon/PimUtil"
+
+#include <AkonadiCore/AgentInstance>
+
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+
+namespace {
+// Don't let a hung agent keep us waiting forever
+static const int sResourceSettingsTimeout = 5000;
+}
+
+CheckFolderFromResourcesJob::CheckFolderFromResourcesJob(QObject *parent)
+    : QObject(parent)
+{
+}
+
+CheckFolderFromResourcesJob::~CheckFolderFromResourcesJob()
+{
+}
+
+void CheckFolderFromResourcesJob::setCollections(const Akonadi::Collection::List &collections)
+{
+    mCollections = collections;
+}
+
+void CheckFolderFromResourcesJob::setCachedSettings(const QHash<QString, Akonadi::Collection::Id> &cache)
+{
+    mCachedSettings = cache;
+}
+
+bool CheckFolderFromResourcesJob::containsCollection(Akonadi::Collection::Id collectionId) const
+{
+    for (const Akonadi::Collection &collection : qAsConst(mCollections)) {
+        if (collection.id() == collectionId) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void CheckFolderFromResourcesJob::start()
+{
+    if (mCollections.isEmpty()) {
+        checkFinished();
+        return;
+    }
+    const Akonadi::AgentInstance::List lst = MailCommon::Util::agentInstances();
+    for (const Akonadi::AgentInstance &type : lst) {
+        if (type.status() == Akonadi::AgentInstance::Broken) {
+            continue;
+        }
+        const QString typeIdentifier(type.identifier());
+        const auto cached = mCachedSettings.constFind(typeIdentifier);
+        if (cached != mCachedSettings.constEnd() && !containsCollection(cached.value())) {
+            continue;
+        }
+        if (PimCommon::Util::isImapResource(typeIdentifier)) {
+            queryResource(typeIdentifier, Imap);
+        } else if (typeIdentifier.contains(POP3_RESOURCE_IDENTIFIER)) {
+            queryResource(typeIdentifier, Pop3);
+        }
+    }
+    checkFinished();
+}
+
+void CheckFolderFromResourcesJob::queryResource(const QString &identifier, ResourceType type)
+{
+    QDBusAbstractInterface *iface = nullptr;
+    QDBusPendingReply<qlonglong> reply;
+    if (type == Imap) {
+        OrgKdeAkonadiImapSettingsInterface *imapIface = PimCommon::Util::createImapSettingsInterface(identifier);
+        if (!imapIface) {
+            return;
+        }
+        imapIface->setTimeout(sResourceSettingsTimeout);
+        reply = imapIface->trashCollection();
+        iface = imapIface;
+    } else {
+        OrgKdeAkonadiPOP3SettingsInterface *pop3Iface = MailCommon::Util::createPop3SettingsInterface(identifier);
+        if (!pop3Iface) {
+            return;
+        }
+        pop3Iface->setTimeout(sResourceSettingsTimeout);
+        reply = pop3Iface->targetCollection();
+        iface = pop3Iface;
+    }
+    iface->setParent(this);
+    ++mPendingCalls;
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(reply, this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, iface, identifier, type](QDBusPendingCallWatcher *watcher) {
+        slotSettingRead(watcher, iface, identifier, type);
+    });
+}
+
+void CheckFolderFromResourcesJob::slotSettingRead(QDBusPendingCallWatcher *watcher, QDBusAbstractInterface *iface, const QString &identifier, ResourceType type)
+{
+    QDBusPendingReply<qlonglong> reply = *watcher;
+    watcher->deleteLater();
+    --mPendingCalls;
+
+    if (reply.isError()) {
+        qCWarning(KMAIL_LOG) << "Unable to read settings of resource" << identifier << ":" << reply.error().message();
+    } else {
+        const Akonadi::Collection::Id collectionId = reply.value();
+        if (containsCollection(collectionId)) {
+            if (type == Imap) {
+                //Use default trash
+                auto imapIface = static_cast<OrgKdeAkonadiImapSettingsInterface *>(iface);
+                const Akonadi::Collection::Id trashId = CommonKernel->trashCollectionFolder().id();
+                imapIface->setTrashCollection(trashId);
+                imapIface->save();
+                Q_EMIT resourceSettingRead(identifier, trashId);
+            } else {
+                //Use default inbox
+                auto pop3Iface = static_cast<OrgKdeAkonadiPOP3SettingsInterface *>(iface);
+                const Akonadi::Collection::Id inboxId = CommonKernel->inboxCollectionFolder().id();
+                pop3Iface->setTargetCollection(inboxId);
+                pop3Iface->save();
+                Q_EMIT resourceSettingRead(identifier, inboxId);
+            }
+        } else {
+            Q_EMIT resourceSettingRead(identifier, collectionId);
+        }
+    }
+    iface->deleteLater();
+    checkFinished();
+}
+
+void CheckFolderFromResourcesJob::checkFinished()
+{
+    if (mPendingCalls == 0) {
+        Q_EMIT finished();
+        deleteLater();
+    }
+}
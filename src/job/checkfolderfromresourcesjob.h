@@ -0,0 +1,70 @@
+/*
+   Copyright (C) 2026 KDE e.V.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef CHECKFOLDERFROMRESOURCESJOB_H
+#define CHECKFOLDERFROMRESOURCESJOB_H
+
+#include <QObject>
+#include <QHash>
+#include <AkonadiCore/Collection>
+
+class QDBusPendingCallWatcher;
+class QDBusAbstractInterface;
+/**
+ * Resets the trash folder of IMAP resources and the target folder of POP3
+ * resources when they point to one of the given collections.
+ *
+ * The resources are queried in parallel through asynchronous D-Bus calls,
+ * so a hung agent never blocks the GUI. Settings already known from a
+ * previous run are passed in with setCachedSettings() and only resources
+ * whose cached folder matches one of the collections are queried again.
+ */
+class CheckFolderFromResourcesJob : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CheckFolderFromResourcesJob(QObject *parent = nullptr);
+    ~CheckFolderFromResourcesJob();
+
+    void setCollections(const Akonadi::Collection::List &collections);
+    void setCachedSettings(const QHash<QString, Akonadi::Collection::Id> &cache);
+
+    void start();
+
+Q_SIGNALS:
+    void resourceSettingRead(const QString &identifier, Akonadi::Collection::Id collectionId);
+    void finished();
+
+private:
+    Q_DISABLE_COPY(CheckFolderFromResourcesJob)
+    enum ResourceType {
+        Imap,
+        Pop3
+    };
+    bool containsCollection(Akonadi::Collection::Id collectionId) const;
+    void queryResource(const QString &identifier, ResourceType type);
+    void slotSettingRead(QDBusPendingCallWatcher *watcher, QDBusAbstractInterface *iface, const QString &identifier, ResourceType type);
+    void checkFinished();
+
+    Akonadi::Collection::List mCollections;
+    QHash<QString, Akonadi::Collection::Id> mCachedSettings;
+    int mPendingCalls = 0;
+};
+
+#endif // CHECKFOLDERFROMRESOURCESJOB_H
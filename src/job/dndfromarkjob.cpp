@@ -23,6 +23,8 @@
 
 #include <QDBusConnection>
 #include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
 #include <QDir>
 #include <QMimeData>
 #include <QTemporaryDir>
@@ -33,6 +35,11 @@ DndFromArkJob::DndFromArkJob(QObject *parent)
 {
 }
 
+DndFromArkJob::~DndFromArkJob()
+{
+    delete mLinkDir;
+}
+
 bool DndFromArkJob::dndFromArk(const QMimeData *source)
 {
     if (source->hasFormat(QStringLiteral("application/x-kde-ark-dndextract-service"))
@@ -56,23 +63,36 @@ bool DndFromArkJob::extract(const QMimeData *source)
         const QString tmpPath = QDir::tempPath() + QLatin1String("/attachments_ark");
         QDir().mkpath(tmpPath);
 
-        QTemporaryDir *linkDir = new QTemporaryDir(tmpPath);
-        const QString arkPath = linkDir->path();
+        mLinkDir = new QTemporaryDir(tmpPath);
+        const QString arkPath = mLinkDir->path();
         QDBusMessage message = QDBusMessage::createMethodCall(remoteDBusClient, remoteDBusPath,
                                                               QStringLiteral("org.kde.ark.DndExtract"), QStringLiteral("extractSelectedFilesTo"));
         message.setArguments({arkPath});
-        QDBusConnection::sessionBus().call(message);
-        QDir dir(arkPath);
-        QStringList list = dir.entryList(QDir::NoDotAndDotDot | QDir::Files);
+        //Ark can take a long time to extract big archives, don't block the composer meanwhile
+        QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(QDBusConnection::sessionBus().asyncCall(message, 60000), this);
+        connect(watcher, &QDBusPendingCallWatcher::finished, this, &DndFromArkJob::slotExtractFinished);
+        return true;
+    }
+    deleteLater();
+    return false;
+}
+
+void DndFromArkJob::slotExtractFinished(QDBusPendingCallWatcher *watcher)
+{
+    const QDBusPendingReply<> reply = *watcher;
+    watcher->deleteLater();
+    if (reply.isError()) {
+        qCWarning(KMAIL_LOG) << "Impossible to extract files from ark:" << reply.error().message();
+    } else if (mComposerWin) {
+        QDir dir(mLinkDir->path());
+        const QStringList list = dir.entryList(QDir::NoDotAndDotDot | QDir::Files);
         for (int i = 0; i < list.size(); ++i) {
             mComposerWin->addAttachment(QUrl::fromLocalFile(list.at(i)), QString());
         }
-        delete linkDir;
-        deleteLater();
-        return true;
     }
+    delete mLinkDir;
+    mLinkDir = nullptr;
     deleteLater();
-    return false;
 }
 
 void DndFromArkJob::setComposerWin(KMComposerWin *composerWin)
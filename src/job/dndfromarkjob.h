@@ -21,20 +21,26 @@
 #define DNDFROMARKJOB_H
 
 #include <QObject>
+#include <QPointer>
 
 class QMimeData;
+class QTemporaryDir;
+class QDBusPendingCallWatcher;
 class KMComposerWin;
 class DndFromArkJob : public QObject
 {
     Q_OBJECT
 public:
     explicit DndFromArkJob(QObject *parent = nullptr);
+    ~DndFromArkJob() override;
     static bool dndFromArk(const QMimeData *source);
     bool extract(const QMimeData *source);
     void setComposerWin(KMComposerWin *composerWin);
 
 private:
-    KMComposerWin *mComposerWin = nullptr;
+    void slotExtractFinished(QDBusPendingCallWatcher *watcher);
+    QPointer<KMComposerWin> mComposerWin;
+    QTemporaryDir *mLinkDir = nullptr;
 };
 
 #endif // DNDFROMARKJOB_H
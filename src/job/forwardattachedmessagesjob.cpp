@@ -0,0 +1,271 @@
+/*
+   Copyright (C) 2026 KDE e.V.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+
+#include "forwardattachedmessagesjob.h"
+#include "kmkernel.h"
+#include "kmail_debug.h"
+#include "editor/composer.h"
+
+#include <Akonadi/KMime/MessageStatus>
+#include <AkonadiCore/ItemFetchJob>
+#include <AkonadiCore/ItemFetchScope>
+#include <Libkdepim/ProgressManager>
+#include <MailCommon/MailKernel>
+#include <MailCommon/MailUtil>
+#include <MessageComposer/MessageFactoryNG>
+#include <MessageComposer/Util>
+#include <KLocalizedString>
+#include <KMime/Content>
+
+#include <algorithm>
+
+namespace {
+// Number of messages fetched and parsed at the same time
+static const int sFetchChunkSize = 50;
+}
+
+ForwardAttachedMessagesJob::ForwardAttachedMessagesJob(QObject *parent)
+    : QObject(parent)
+{
+}
+
+ForwardAttachedMessagesJob::~ForwardAttachedMessagesJob()
+{
+}
+
+void ForwardAttachedMessagesJob::setItems(const Akonadi::Item::List &items)
+{
+    mItems = items;
+}
+
+void ForwardAttachedMessagesJob::setMode(Mode mode)
+{
+    mMode = mode;
+}
+
+void ForwardAttachedMessagesJob::setIdentity(uint identity)
+{
+    mIdentity = identity;
+}
+
+void ForwardAttachedMessagesJob::setComposer(KMail::Composer *composer)
+{
+    mComposer = composer;
+}
+
+void ForwardAttachedMessagesJob::appendDigestPart(QByteArray &digestBody, const QByteArray &boundary, const QByteArray &part)
+{
+    digestBody += "\n--" + boundary + '\n';
+    digestBody += part;
+}
+
+KMime::Content *ForwardAttachedMessagesJob::createDigest(const QByteArray &digestBody, const QByteArray &boundary, int count)
+{
+    KMime::Content *digest = new KMime::Content;
+    digest->contentType()->setMimeType("multipart/digest");
+    digest->contentType()->setBoundary(boundary);
+    digest->contentDescription()->fromUnicodeString(QStringLiteral("Digest of %1 messages.").arg(count), "utf8");
+    digest->contentDisposition()->setFilename(QStringLiteral("digest"));
+    digest->assemble();
+    QByteArray body = i18n("\nThis is a MIME digest forward. The content of the message is contained in the attachment(s).\n\n\n").toUtf8();
+    body += digestBody;
+    body += "\n--" + boundary + "--\n";
+    digest->setBody(body);
+    digest->parse();
+    return digest;
+}
+
+void ForwardAttachedMessagesJob::start()
+{
+    if (mItems.isEmpty()) {
+        finish(true);
+        return;
+    }
+    if (mComposer) {
+        mComposer->blockSending(true);
+        mSendingBlocked = true;
+    }
+    mBoundary = KMime::multiPartBoundary();
+    if (mItems.count() > sFetchChunkSize) {
+        mProgressItem = KPIM::ProgressManager::createProgressItem(QLatin1String("forwardattached") + KPIM::ProgressManager::getUniqueID(),
+                                                                  i18n("Forwarding messages"), QString(), true, KPIM::ProgressItem::Unknown);
+        connect(mProgressItem.data(), &KPIM::ProgressItem::progressItemCanceled,
+                this, &ForwardAttachedMessagesJob::slotCanceled);
+        updateProgress();
+    }
+    fetchNextChunk();
+}
+
+void ForwardAttachedMessagesJob::fetchNextChunk()
+{
+    while (mNextItem < mItems.count()) {
+        const Akonadi::Item::List chunk = mItems.mid(mNextItem, sFetchChunkSize);
+        mNextItem += chunk.count();
+
+        // Standalone messages (e.g. opened from a file) already carry their payload
+        const bool loaded = std::all_of(chunk.cbegin(), chunk.cend(), [](const Akonadi::Item &item) {
+            return item.hasPayload<KMime::Message::Ptr>();
+        });
+        if (!loaded) {
+            Akonadi::ItemFetchJob *job = new Akonadi::ItemFetchJob(chunk, this);
+            job->fetchScope().fetchFullPayload(true);
+            job->fetchScope().setAncestorRetrieval(Akonadi::ItemFetchScope::Parent);
+            connect(job, &Akonadi::ItemFetchJob::itemsReceived, this, &ForwardAttachedMessagesJob::slotItemsReceived);
+            connect(job, &KJob::result, this, &ForwardAttachedMessagesJob::slotFetchResult);
+            mCurrentJob = job;
+            return;
+        }
+        forwardChunk(chunk);
+        if (mCanceled) {
+            return;
+        }
+    }
+
+    if (mMode == Digest && mComposer) {
+        KMime::Content *digest = createDigest(mDigestBody, mBoundary, mForwardedMessages);
+        mDigestBody.clear();
+        mComposer->addAttach(digest);
+        delete digest;
+    }
+    finish(true);
+}
+
+void ForwardAttachedMessagesJob::slotItemsReceived(const Akonadi::Item::List &items)
+{
+    mFetchedItems += items;
+}
+
+void ForwardAttachedMessagesJob::slotFetchResult(KJob *job)
+{
+    mCurrentJob = nullptr;
+    if (mCanceled) {
+        return;
+    }
+    if (job->error()) {
+        qCWarning(KMAIL_LOG) << "Unable to fetch messages to forward:" << job->errorString();
+        finish(false);
+        return;
+    }
+    const Akonadi::Item::List items = mFetchedItems;
+    mFetchedItems.clear();
+    forwardChunk(items);
+    if (!mCanceled) {
+        fetchNextChunk();
+    }
+}
+
+void ForwardAttachedMessagesJob::forwardChunk(const Akonadi::Item::List &items)
+{
+    if (items.isEmpty()) {
+        return;
+    }
+    if ((mForwardedMessages > 0 || mSendingBlocked) && !mComposer) {
+        // The composer was closed while we were still attaching messages
+        slotCanceled();
+        return;
+    }
+
+    const Akonadi::Item firstItem(items.first());
+    MessageComposer::MessageFactoryNG factory(KMime::Message::Ptr(new KMime::Message), firstItem.id(),
+                                              CommonKernel->collectionFromId(firstItem.parentCollection().id()));
+    factory.setIdentityManager(KMKernel::self()->identityManager());
+    factory.setFolderIdentity(MailCommon::Util::folderIdentity(firstItem));
+
+    KMime::Message::Ptr chunkMessage;
+    if (mMode == Digest) {
+        const QPair<KMime::Message::Ptr, KMime::Content *> fwdMsg = factory.createForwardDigestMIME(items);
+        chunkMessage = fwdMsg.first;
+        // Keep the serialized parts only, the parsed messages go away with the chunk.
+        // The digest is a single attachment, so they are needed until the end
+        const auto contents = fwdMsg.second->contents();
+        for (KMime::Content *part : contents) {
+            appendDigestPart(mDigestBody, mBoundary, part->encodedContent());
+        }
+        delete fwdMsg.second;
+    } else {
+        const QPair<KMime::Message::Ptr, QList<KMime::Content *> > fwdMsg = factory.createAttachedForward(items);
+        chunkMessage = fwdMsg.first;
+        if (!mComposer) {
+            mComposer = KMail::makeComposer(chunkMessage, false, false, KMail::Composer::Forward, mIdentity);
+            mMessage = chunkMessage;
+            mOwnsComposer = true;
+        }
+        for (KMime::Content *attach : qAsConst(fwdMsg.second)) {
+            mComposer->addAttach(attach);
+            delete attach;
+        }
+    }
+
+    if (!mComposer) {
+        mComposer = KMail::makeComposer(chunkMessage, false, false, KMail::Composer::Forward, mIdentity);
+        mMessage = chunkMessage;
+        mOwnsComposer = true;
+    } else if (mMessage && mMessage != chunkMessage) {
+        // The composer shares its message with us: mark the later messages
+        // as forwarded too once it is sent
+        for (const Akonadi::Item &item : items) {
+            MessageComposer::Util::addLinkInformation(mMessage, item.id(), Akonadi::MessageStatus::statusForwarded());
+        }
+    }
+    mForwardedMessages += items.count();
+    updateProgress();
+}
+
+void ForwardAttachedMessagesJob::slotCanceled()
+{
+    mCanceled = true;
+    if (mCurrentJob) {
+        mCurrentJob->kill();
+        mCurrentJob = nullptr;
+    }
+    finish(false);
+}
+
+void ForwardAttachedMessagesJob::updateProgress()
+{
+    if (!mProgressItem) {
+        return;
+    }
+    mProgressItem->setStatus(i18np("%2 of one message forwarded", "%2 of %1 messages forwarded",
+                                   mItems.count(), mForwardedMessages));
+    mProgressItem->setProgress(100 * mForwardedMessages / mItems.count());
+}
+
+void ForwardAttachedMessagesJob::finish(bool success)
+{
+    if (mProgressItem) {
+        mProgressItem->setComplete();
+        mProgressItem = nullptr;
+    }
+    if (mComposer && mSendingBlocked) {
+        mComposer->blockSending(false);
+    } else if (mComposer && mOwnsComposer) {
+        if (success) {
+            // Only now the message carries every forwarded message
+            mComposer->show();
+        } else {
+            // Never shown, drop it without asking to save a partial forward
+            mComposer->setModified(false);
+            mComposer->close();
+        }
+    }
+    Q_EMIT finished(success);
+    deleteLater();
+}
@@ -0,0 +1,101 @@
+/*
+   Copyright (C) 2026 KDE e.V.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef FORWARDATTACHEDMESSAGESJOB_H
+#define FORWARDATTACHEDMESSAGESJOB_H
+
+#include <QObject>
+#include <QPointer>
+#include <AkonadiCore/Item>
+#include <KMime/Message>
+#include "kmail_export.h"
+
+class KJob;
+namespace KMail {
+class Composer;
+}
+namespace KPIM {
+class ProgressItem;
+}
+/**
+ * Forwards messages as attachments or as a MIME digest.
+ *
+ * Messages are fetched and parsed in small chunks, so only one chunk of
+ * Akonadi items and parsed messages is alive at a time. The forwarded
+ * data itself still ends up in memory as a whole: the composer keeps its
+ * attachments there, and the digest is collected in serialized form until
+ * the last chunk has arrived.
+ *
+ * A composer created by the job is only shown once every message has been
+ * attached, and is discarded if the job fails or is canceled. A composer
+ * passed in with setComposer() cannot send the message while the job runs.
+ */
+class KMAIL_EXPORT ForwardAttachedMessagesJob : public QObject
+{
+    Q_OBJECT
+public:
+    enum Mode {
+        Attached = 0,
+        Digest
+    };
+
+    explicit ForwardAttachedMessagesJob(QObject *parent = nullptr);
+    ~ForwardAttachedMessagesJob();
+
+    void setItems(const Akonadi::Item::List &items);
+    void setMode(Mode mode);
+    void setIdentity(uint identity);
+    void setComposer(KMail::Composer *composer);
+
+    void start();
+
+    static void appendDigestPart(QByteArray &digestBody, const QByteArray &boundary, const QByteArray &part);
+    static KMime::Content *createDigest(const QByteArray &digestBody, const QByteArray &boundary, int count);
+
+Q_SIGNALS:
+    void finished(bool success);
+
+private:
+    Q_DISABLE_COPY(ForwardAttachedMessagesJob)
+    void fetchNextChunk();
+    void slotItemsReceived(const Akonadi::Item::List &items);
+    void slotFetchResult(KJob *job);
+    void slotCanceled();
+    void forwardChunk(const Akonadi::Item::List &items);
+    void updateProgress();
+    void finish(bool success);
+
+    Akonadi::Item::List mItems;
+    Akonadi::Item::List mFetchedItems;
+    QPointer<KMail::Composer> mComposer;
+    KMime::Message::Ptr mMessage;
+    QPointer<KPIM::ProgressItem> mProgressItem;
+    KJob *mCurrentJob = nullptr;
+    QByteArray mDigestBody;
+    QByteArray mBoundary;
+    Mode mMode = Attached;
+    uint mIdentity = 0;
+    int mNextItem = 0;
+    int mForwardedMessages = 0;
+    bool mOwnsComposer = false;
+    bool mSendingBlocked = false;
+    bool mCanceled = false;
+};
+
+#endif // FORWARDATTACHEDMESSAGESJOB_H
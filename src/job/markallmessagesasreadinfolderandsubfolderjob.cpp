@@ -21,6 +21,19 @@
 #include "markallmessagesasreadinfolderandsubfolderjob.h"
 #include <PimCommonAkonadi/FetchRecursiveCollectionsJob>
 #include "kmail_debug.h"
+#include "libkdepim/progressmanager.h"
+#include "MailCommon/MailKernel"
+#include <AkonadiCore/ItemFetchJob>
+#include <AkonadiCore/ItemFetchScope>
+#include <AkonadiCore/ItemModifyJob>
+#include <Akonadi/KMime/MessageFlags>
+#include <KLocalizedString>
+
+namespace {
+static const int sMaximumRunningCollections = 2;
+static const int sModifyBatchSize = 1000;
+static const char sCollectionIdProperty[] = "collectionId";
+}
 
 MarkAllMessagesAsReadInFolderAndSubFolderJob::MarkAllMessagesAsReadInFolderAndSubFolderJob(QObject *parent)
     : QObject(parent)
@@ -58,28 +71,160 @@ void MarkAllMessagesAsReadInFolderAndSubFolderJob::slotFetchCollectionFailed()
 
 void MarkAllMessagesAsReadInFolderAndSubFolderJob::slotFetchCollectionDone(const Akonadi::Collection::List &list)
 {
-    Akonadi::MessageStatus messageStatus;
-    messageStatus.setRead(true);
-    Akonadi::MarkAsCommand *markAsReadAllJob = new Akonadi::MarkAsCommand(messageStatus, list);
-    connect(markAsReadAllJob, &Akonadi::MarkAsCommand::result, this, &MarkAllMessagesAsReadInFolderAndSubFolderJob::slotMarkAsResult);
-    markAsReadAllJob->execute();
+    for (const Akonadi::Collection &collection : list) {
+        if (!collection.isValid()) {
+            continue;
+        }
+        // Folders known to have no unread messages don't need to be looked at.
+        const Akonadi::Collection col = CommonKernel->collectionFromId(collection.id());
+        if (col.isValid() && col.statistics().unreadCount() == 0) {
+            continue;
+        }
+        mCollections.append(collection);
+    }
+    if (mCollections.isEmpty()) {
+        qCDebug(KMAIL_LOG()) << "MarkAllMessagesAsReadInFolderAndSubFoldeJob: no unread messages";
+        deleteLater();
+        return;
+    }
+    mNumberOfCollections = mCollections.count();
+
+    mProgressItem = KPIM::ProgressManager::createProgressItem(i18n("Marking messages as read"), QString(), true);
+    mProgressItem->setCryptoStatus(KPIM::ProgressItem::Unknown);
+    connect(mProgressItem.data(), &KPIM::ProgressItem::progressItemCanceled, this, &MarkAllMessagesAsReadInFolderAndSubFolderJob::slotCanceled);
+    updateProgress();
+
+    startNextCollections();
 }
 
-void MarkAllMessagesAsReadInFolderAndSubFolderJob::slotMarkAsResult(Akonadi::MarkAsCommand::Result result)
+void MarkAllMessagesAsReadInFolderAndSubFolderJob::startNextCollections()
 {
-    switch (result) {
-    case Akonadi::MarkAsCommand::Undefined:
-        qCDebug(KMAIL_LOG()) << "MarkAllMessagesAsReadInFolderAndSubFolderJob undefined result";
-        break;
-    case Akonadi::MarkAsCommand::OK:
-        qCDebug(KMAIL_LOG()) << "MarkAllMessagesAsReadInFolderAndSubFoldeJob Done";
-        break;
-    case Akonadi::MarkAsCommand::Canceled:
+    while (!mCanceled && !mCollections.isEmpty() && mRunningJobs.count() < sMaximumRunningCollections) {
+        const Akonadi::Collection collection = mCollections.takeFirst();
+
+        // Only the flags are needed to know which messages are unread.
+        Akonadi::ItemFetchJob *job = new Akonadi::ItemFetchJob(collection, this);
+        job->setDeliveryOption(Akonadi::ItemFetchJob::EmitItemsInBatches);
+        job->fetchScope().setFetchModificationTime(false);
+        job->fetchScope().setFetchRemoteIdentification(false);
+        job->fetchScope().setFetchGid(false);
+        const Akonadi::Collection::Id collectionId = collection.id();
+        job->setProperty(sCollectionIdProperty, collectionId);
+        connect(job, &Akonadi::ItemFetchJob::itemsReceived, this, [this, collectionId](const Akonadi::Item::List &items) {
+            slotItemsReceived(collectionId, items);
+        });
+        connect(job, &Akonadi::ItemFetchJob::result, this, &MarkAllMessagesAsReadInFolderAndSubFolderJob::slotItemFetchDone);
+        mRunningJobs.insert(collectionId, 1);
+    }
+}
+
+void MarkAllMessagesAsReadInFolderAndSubFolderJob::slotItemsReceived(Akonadi::Collection::Id collectionId, const Akonadi::Item::List &items)
+{
+    if (mCanceled) {
+        return;
+    }
+    Akonadi::Item::List &unreadItems = mUnreadItems[collectionId];
+    for (const Akonadi::Item &item : items) {
+        if (!item.hasFlag(Akonadi::MessageFlags::Seen)) {
+            unreadItems.append(item);
+        }
+    }
+    if (unreadItems.count() >= sModifyBatchSize) {
+        modifyItems(collectionId);
+    }
+}
+
+void MarkAllMessagesAsReadInFolderAndSubFolderJob::slotItemFetchDone(KJob *job)
+{
+    const Akonadi::Collection::Id collectionId = job->property(sCollectionIdProperty).toLongLong();
+    if (job->error()) {
+        qCDebug(KMAIL_LOG()) << "Unable to fetch items of collection" << collectionId << job->errorString();
+    } else if (!mCanceled) {
+        modifyItems(collectionId);
+    }
+    jobFinished(collectionId);
+}
+
+void MarkAllMessagesAsReadInFolderAndSubFolderJob::modifyItems(Akonadi::Collection::Id collectionId)
+{
+    Akonadi::Item::List items = mUnreadItems.take(collectionId);
+    if (items.isEmpty()) {
+        return;
+    }
+    // Modifying several items at once only sends the flag change to the server.
+    for (Akonadi::Item &item : items) {
+        item.setFlag(Akonadi::MessageFlags::Seen);
+    }
+    Akonadi::ItemModifyJob *modifyJob = new Akonadi::ItemModifyJob(items, this);
+    modifyJob->setIgnorePayload(true);
+    modifyJob->disableRevisionCheck();
+    modifyJob->setProperty(sCollectionIdProperty, collectionId);
+    modifyJob->setProperty("itemCount", items.count());
+    connect(modifyJob, &Akonadi::ItemModifyJob::result, this, &MarkAllMessagesAsReadInFolderAndSubFolderJob::slotModifyDone);
+    ++mRunningJobs[collectionId];
+}
+
+void MarkAllMessagesAsReadInFolderAndSubFolderJob::slotModifyDone(KJob *job)
+{
+    if (job->error()) {
+        qCDebug(KMAIL_LOG()) << "Unable to mark messages as read" << job->errorString();
+    } else {
+        mMarkedItems += job->property("itemCount").toInt();
+        updateProgress();
+    }
+    jobFinished(job->property(sCollectionIdProperty).toLongLong());
+}
+
+void MarkAllMessagesAsReadInFolderAndSubFolderJob::jobFinished(Akonadi::Collection::Id collectionId)
+{
+    auto it = mRunningJobs.find(collectionId);
+    if (it == mRunningJobs.end()) {
+        return;
+    }
+    if (--it.value() > 0) {
+        return;
+    }
+    mRunningJobs.erase(it);
+    ++mFinishedCollections;
+    updateProgress();
+    startNextCollections();
+    if (mRunningJobs.isEmpty() && (mCanceled || mCollections.isEmpty())) {
+        finish();
+    }
+}
+
+void MarkAllMessagesAsReadInFolderAndSubFolderJob::updateProgress()
+{
+    if (!mProgressItem) {
+        return;
+    }
+    mProgressItem->setStatus(i18np("Folder %2 of %3: one message marked as read",
+                                   "Folder %2 of %3: %1 messages marked as read",
+                                   mMarkedItems,
+                                   qMin(mFinishedCollections + 1, mNumberOfCollections),
+                                   mNumberOfCollections));
+    mProgressItem->setProgress(mNumberOfCollections > 0 ? (100 * mFinishedCollections / mNumberOfCollections) : 0);
+}
+
+void MarkAllMessagesAsReadInFolderAndSubFolderJob::slotCanceled()
+{
+    // Modify jobs which are already queued are not interrupted, the running
+    // fetches stop to produce new ones.
+    mCanceled = true;
+    mCollections.clear();
+    mUnreadItems.clear();
+}
+
+void MarkAllMessagesAsReadInFolderAndSubFolderJob::finish()
+{
+    if (mCanceled) {
         qCDebug(KMAIL_LOG()) << "MarkAllMessagesAsReadInFolderAndSubFoldeJob was canceled";
-        break;
-    case Akonadi::MarkAsCommand::Failed:
-        qCDebug(KMAIL_LOG()) << "MarkAllMessagesAsReadInFolderAndSubFoldeJob was failed";
-        break;
+    } else {
+        qCDebug(KMAIL_LOG()) << "MarkAllMessagesAsReadInFolderAndSubFoldeJob Done";
+    }
+    if (mProgressItem) {
+        mProgressItem->setComplete();
+        mProgressItem = nullptr;
     }
     deleteLater();
 }
@@ -22,10 +22,22 @@
 #define MARKALLMESSAGESASREADINFOLDERANDSUBFOLDERJOB_H
 
 #include <QObject>
+#include <QHash>
+#include <QPointer>
 
 #include <Collection>
-#include <Akonadi/KMime/MarkAsCommand>
+#include <AkonadiCore/Item>
 
+class KJob;
+namespace KPIM {
+class ProgressItem;
+}
+/**
+ * Marks all messages of a folder and of its subfolders as read.
+ *
+ * Only the flags of the items are fetched, a few folders at a time, and
+ * the unread ones are marked in batches with a single modify job each.
+ */
 class MarkAllMessagesAsReadInFolderAndSubFolderJob : public QObject
 {
     Q_OBJECT
@@ -40,8 +52,24 @@ private:
     Q_DISABLE_COPY(MarkAllMessagesAsReadInFolderAndSubFolderJob)
     void slotFetchCollectionFailed();
     void slotFetchCollectionDone(const Akonadi::Collection::List &list);
-    void slotMarkAsResult(Akonadi::MarkAsCommand::Result result);
+    void startNextCollections();
+    void slotItemsReceived(Akonadi::Collection::Id collectionId, const Akonadi::Item::List &items);
+    void slotItemFetchDone(KJob *job);
+    void slotModifyDone(KJob *job);
+    void modifyItems(Akonadi::Collection::Id collectionId);
+    void jobFinished(Akonadi::Collection::Id collectionId);
+    void slotCanceled();
+    void updateProgress();
+    void finish();
+
     Akonadi::Collection mTopLevelCollection;
+    Akonadi::Collection::List mCollections;
+    QHash<Akonadi::Collection::Id, Akonadi::Item::List> mUnreadItems;
+    QHash<Akonadi::Collection::Id, int> mRunningJobs;
+    QPointer<KPIM::ProgressItem> mProgressItem;
+    int mNumberOfCollections = 0;
+    int mFinishedCollections = 0;
+    qint64 mMarkedItems = 0;
+    bool mCanceled = false;
 };
-
 #endif // MARKALLMESSAGESASREADINFOLDERANDSUBFOLDERJOB_H
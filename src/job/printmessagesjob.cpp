@@ -0,0 +1,251 @@
+/*
+   Copyright (C) 2026 KDE e.V.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+
+#include "printmessagesjob.h"
+#include "kmreaderwin.h"
+#include "kmail_debug.h"
+
+#include <AkonadiCore/ItemFetchJob>
+#include <AkonadiCore/ItemFetchScope>
+#include <Libkdepim/ProgressManager>
+#include <MessageViewer/AttachmentStrategy>
+#include <MessageViewer/Viewer>
+#include <KLocalizedString>
+#include <KMessageBox>
+
+#include <QDateTime>
+#include <QHash>
+
+#include <algorithm>
+
+namespace {
+// Number of messages printed by one print job
+static const int sPrintBatchSize = 50;
+}
+
+PrintMessagesJob::PrintMessagesJob(QObject *parent)
+    : QObject(parent)
+{
+}
+
+PrintMessagesJob::~PrintMessagesJob()
+{
+}
+
+void PrintMessagesJob::setItems(const Akonadi::Item::List &items)
+{
+    mItems = items;
+}
+
+void PrintMessagesJob::setPrintCommandInfo(const KMPrintCommandInfo &info)
+{
+    mPrintCommandInfo = info;
+}
+
+KMime::Message::Ptr PrintMessagesJob::createPrintMessage(const QVector<KMime::Message::Ptr> &messages)
+{
+    const QByteArray boundary = KMime::multiPartBoundary();
+    KMime::Message::Ptr printMsg(new KMime::Message);
+    printMsg->subject()->fromUnicodeString(i18np("One message", "%1 messages", messages.count()), "utf-8");
+    printMsg->date()->setDateTime(QDateTime::currentDateTime());
+    printMsg->contentType()->setMimeType("multipart/mixed");
+    printMsg->contentType()->setBoundary(boundary);
+    printMsg->assemble();
+
+    QByteArray body;
+    for (const KMime::Message::Ptr &msg : messages) {
+        body += "--" + boundary + '\n';
+        body += "Content-Type: message/rfc822\nContent-Disposition: inline\n\n";
+        body += msg->encodedContent();
+        body += '\n';
+    }
+    body += "--" + boundary + "--\n";
+    printMsg->setBody(body);
+    printMsg->parse();
+    return printMsg;
+}
+
+void PrintMessagesJob::start()
+{
+    if (mItems.isEmpty()) {
+        finish(true);
+        return;
+    }
+    if (!mPrintCommandInfo.mAttachmentStrategy) {
+        // Show the printed messages inline instead of as attachment icons
+        mPrintCommandInfo.mAttachmentStrategy = MessageViewer::AttachmentStrategy::inlined();
+    }
+    const int batches = (mItems.count() + sPrintBatchSize - 1) / sPrintBatchSize;
+    if (batches > 1) {
+        // The viewer shows its own print dialog for every batch
+        const int answer = KMessageBox::warningContinueCancel(nullptr,
+                                                              i18n("The %1 selected messages are printed in %2 parts of up to %3 messages each. "
+                                                                   "The print dialog is shown once for every part; when printing to a file, "
+                                                                   "choose a different file name for each part.",
+                                                                   mItems.count(), batches, sPrintBatchSize),
+                                                              i18n("Print Messages"));
+        if (answer != KMessageBox::Continue) {
+            finish(false);
+            return;
+        }
+    }
+    mPrinterWin = KMPrintCommand::createPrinterWin(mPrintCommandInfo);
+    mPrinterWin->setDeleteAfterPrinting(false);
+    connect(mPrinterWin.data(), &KMReaderWin::printingFinished, this, &PrintMessagesJob::slotPrintingFinished);
+
+    mProgressItem = KPIM::ProgressManager::createProgressItem(QLatin1String("print") + KPIM::ProgressManager::getUniqueID(),
+                                                              i18n("Printing messages"), QString(), true, KPIM::ProgressItem::Unknown);
+    connect(mProgressItem.data(), &KPIM::ProgressItem::progressItemCanceled,
+            this, &PrintMessagesJob::slotCanceled);
+    updateProgress();
+    fetchNextBatch();
+}
+
+void PrintMessagesJob::fetchNextBatch()
+{
+    if (mNextItem >= mItems.count()) {
+        finish(true);
+        return;
+    }
+    mBatchItems = mItems.mid(mNextItem, sPrintBatchSize);
+    mNextItem += mBatchItems.count();
+
+    // Standalone messages (e.g. opened from a file) already carry their payload
+    const bool loaded = std::all_of(mBatchItems.cbegin(), mBatchItems.cend(), [](const Akonadi::Item &item) {
+        return item.hasPayload<KMime::Message::Ptr>();
+    });
+    if (loaded) {
+        printBatch();
+        return;
+    }
+
+    Akonadi::ItemFetchJob *job = new Akonadi::ItemFetchJob(mBatchItems, this);
+    job->fetchScope().fetchFullPayload(true);
+    connect(job, &Akonadi::ItemFetchJob::itemsReceived, this, &PrintMessagesJob::slotItemsReceived);
+    connect(job, &KJob::result, this, &PrintMessagesJob::slotFetchResult);
+    mCurrentJob = job;
+}
+
+void PrintMessagesJob::slotItemsReceived(const Akonadi::Item::List &items)
+{
+    mFetchedItems += items;
+}
+
+void PrintMessagesJob::slotFetchResult(KJob *job)
+{
+    mCurrentJob = nullptr;
+    if (mCanceled) {
+        return;
+    }
+    if (job->error()) {
+        qCWarning(KMAIL_LOG) << "Unable to fetch messages to print:" << job->errorString();
+        KMessageBox::error(nullptr, i18n("Unable to retrieve the messages to print:\n%1", job->errorString()));
+        finish(false);
+        return;
+    }
+    printBatch();
+}
+
+void PrintMessagesJob::printBatch()
+{
+    // Fetched items don't necessarily come back in the order they were asked for
+    QHash<Akonadi::Item::Id, Akonadi::Item> fetchedItems;
+    fetchedItems.reserve(mFetchedItems.count());
+    for (const Akonadi::Item &item : qAsConst(mFetchedItems)) {
+        fetchedItems.insert(item.id(), item);
+    }
+    mFetchedItems.clear();
+
+    QVector<KMime::Message::Ptr> messages;
+    messages.reserve(mBatchItems.count());
+    for (const Akonadi::Item &batchItem : qAsConst(mBatchItems)) {
+        const Akonadi::Item item = batchItem.hasPayload<KMime::Message::Ptr>() ? batchItem : fetchedItems.value(batchItem.id());
+        if (item.hasPayload<KMime::Message::Ptr>()) {
+            messages << item.payload<KMime::Message::Ptr>();
+        }
+    }
+    if (messages.isEmpty()) {
+        mPrintedMessages += mBatchItems.count();
+        fetchNextBatch();
+        return;
+    }
+
+    Akonadi::Item printItem;
+    printItem.setMimeType(KMime::Message::mimeType());
+    printItem.setPayload<KMime::Message::Ptr>(createPrintMessage(messages));
+    mPrinting = true;
+    if (mPrintCommandInfo.mPrintPreview) {
+        mPrinterWin->viewer()->printPreviewMessage(printItem);
+    } else {
+        mPrinterWin->viewer()->printMessage(printItem);
+    }
+}
+
+void PrintMessagesJob::slotPrintingFinished()
+{
+    mPrinting = false;
+    if (mCanceled) {
+        return;
+    }
+    mPrintedMessages += mBatchItems.count();
+    mBatchItems.clear();
+    updateProgress();
+    fetchNextBatch();
+}
+
+void PrintMessagesJob::slotCanceled()
+{
+    mCanceled = true;
+    if (mCurrentJob) {
+        mCurrentJob->kill();
+        mCurrentJob = nullptr;
+    }
+    finish(false);
+}
+
+void PrintMessagesJob::updateProgress()
+{
+    if (!mProgressItem) {
+        return;
+    }
+    mProgressItem->setStatus(i18np("%2 of one message printed", "%2 of %1 messages printed",
+                                   mItems.count(), mPrintedMessages));
+    mProgressItem->setProgress(100 * mPrintedMessages / mItems.count());
+}
+
+void PrintMessagesJob::finish(bool success)
+{
+    if (mPrinterWin) {
+        disconnect(mPrinterWin.data(), &KMReaderWin::printingFinished, this, &PrintMessagesJob::slotPrintingFinished);
+        if (mPrinting) {
+            // The print dialog is still open, let the window go away on its own
+            mPrinterWin->setDeleteAfterPrinting(true);
+        } else {
+            mPrinterWin->deleteLater();
+        }
+        mPrinterWin = nullptr;
+    }
+    if (mProgressItem) {
+        mProgressItem->setComplete();
+        mProgressItem = nullptr;
+    }
+    Q_EMIT finished(success);
+    deleteLater();
+}
@@ -0,0 +1,92 @@
+/*
+   Copyright (C) 2026 KDE e.V.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+
+#ifndef PRINTMESSAGESJOB_H
+#define PRINTMESSAGESJOB_H
+
+#include <QObject>
+#include <QPointer>
+#include <QVector>
+#include <AkonadiCore/Item>
+#include <KMime/Message>
+#include "kmcommands.h"
+#include "kmail_export.h"
+
+class KJob;
+class KMReaderWin;
+namespace KPIM {
+class ProgressItem;
+}
+/**
+ * Prints several messages, in order, without creating a viewer per message.
+ *
+ * Messages are fetched in batches. Each batch is wrapped into a single
+ * message containing them as inline message/rfc822 parts, which is printed
+ * as one print job by an off-screen reader window reused for all batches.
+ *
+ * Printing everything into a single print job or PDF is not supported:
+ * MessageViewer::Viewer asks for the printer itself for every message it
+ * prints and does not report whether its dialog was accepted. When more
+ * than one batch is needed the user is told up front that a print dialog
+ * follows for each of them. The whole run is canceled from the progress
+ * item; canceling a single print dialog only skips that batch.
+ */
+class KMAIL_EXPORT PrintMessagesJob : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PrintMessagesJob(QObject *parent = nullptr);
+    ~PrintMessagesJob();
+
+    void setItems(const Akonadi::Item::List &items);
+    void setPrintCommandInfo(const KMPrintCommandInfo &info);
+
+    void start();
+
+    static KMime::Message::Ptr createPrintMessage(const QVector<KMime::Message::Ptr> &messages);
+
+Q_SIGNALS:
+    void finished(bool success);
+
+private:
+    Q_DISABLE_COPY(PrintMessagesJob)
+    void fetchNextBatch();
+    void slotItemsReceived(const Akonadi::Item::List &items);
+    void slotFetchResult(KJob *job);
+    void slotPrintingFinished();
+    void slotCanceled();
+    void printBatch();
+    void updateProgress();
+    void finish(bool success);
+
+    KMPrintCommandInfo mPrintCommandInfo;
+    Akonadi::Item::List mItems;
+    Akonadi::Item::List mBatchItems;
+    Akonadi::Item::List mFetchedItems;
+    QPointer<KMReaderWin> mPrinterWin;
+    QPointer<KPIM::ProgressItem> mProgressItem;
+    KJob *mCurrentJob = nullptr;
+    int mNextItem = 0;
+    int mPrintedMessages = 0;
+    bool mPrinting = false;
+    bool mCanceled = false;
+};
+
+#endif // PRINTMESSAGESJOB_H
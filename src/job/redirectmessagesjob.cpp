@@ -0,0 +1,270 @@
+/*
+   Copyright (C) 2026 KDE e.V.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+
+#include "redirectmessagesjob.h"
+#include "kmkernel.h"
+#include "kmail_debug.h"
+
+#include <Akonadi/KMime/MessageStatus>
+#include <AkonadiCore/ItemFetchJob>
+#include <AkonadiCore/ItemFetchScope>
+#include <Libkdepim/ProgressManager>
+#include <MailCommon/FilterAction>
+#include <MailCommon/MailKernel>
+#include <MailCommon/MailUtil>
+#include <MailCommon/MDNStateAttribute>
+#include <MailTransport/TransportManager>
+#include <MailTransportAkonadi/SentBehaviourAttribute>
+#include <MailTransportAkonadi/TransportAttribute>
+#include <MessageComposer/MessageFactoryNG>
+#include <MessageComposer/Util>
+#include <KLocalizedString>
+#include <KMessageBox>
+#include <KMime/MDN>
+
+#include <QTimer>
+
+namespace {
+// Number of messages fetched by one Akonadi job
+static const int sFetchChunkSize = 50;
+// Number of messages redirected before going back to the event loop
+static const int sRedirectBatchSize = 10;
+}
+
+RedirectMessagesJob::RedirectMessagesJob(QObject *parent)
+    : QObject(parent)
+{
+}
+
+RedirectMessagesJob::~RedirectMessagesJob()
+{
+}
+
+void RedirectMessagesJob::setItems(const Akonadi::Item::List &items)
+{
+    mItems = items;
+}
+
+void RedirectMessagesJob::setSettings(const RedirectMessagesJobSettings &settings)
+{
+    mSettings = settings;
+}
+
+void RedirectMessagesJob::setParentWidget(QWidget *parentWidget)
+{
+    mParentWidget = parentWidget;
+}
+
+void RedirectMessagesJob::start()
+{
+    if (mItems.isEmpty()) {
+        checkFinished();
+        return;
+    }
+    mProgressItem = KPIM::ProgressManager::createProgressItem(QLatin1String("redirect") + KPIM::ProgressManager::getUniqueID(),
+                                                              i18n("Redirecting messages"), QString(), true, KPIM::ProgressItem::Unknown);
+    connect(mProgressItem.data(), &KPIM::ProgressItem::progressItemCanceled,
+            this, &RedirectMessagesJob::slotCanceled);
+    updateProgress();
+    fetchNextChunk();
+}
+
+void RedirectMessagesJob::fetchNextChunk()
+{
+    if (mCurrentJob || mCanceled || mNextItem >= mItems.count()) {
+        return;
+    }
+    const Akonadi::Item::List chunk = mItems.mid(mNextItem, sFetchChunkSize);
+    mNextItem += chunk.count();
+
+    // Standalone messages (e.g. opened from a file) already carry their payload
+    if (chunk.count() == 1 && chunk.first().hasPayload<KMime::Message::Ptr>()) {
+        mQueue += chunk;
+        scheduleRedirect();
+        return;
+    }
+
+    Akonadi::ItemFetchJob *job = new Akonadi::ItemFetchJob(chunk, this);
+    job->fetchScope().fetchFullPayload(true);
+    job->fetchScope().fetchAttribute<MailTransport::SentBehaviourAttribute>();
+    job->fetchScope().fetchAttribute<MailTransport::TransportAttribute>();
+    job->fetchScope().fetchAttribute<MailCommon::MDNStateAttribute>();
+    job->fetchScope().setAncestorRetrieval(Akonadi::ItemFetchScope::Parent);
+    connect(job, &Akonadi::ItemFetchJob::itemsReceived, this, &RedirectMessagesJob::slotItemsReceived);
+    connect(job, &KJob::result, this, &RedirectMessagesJob::slotFetchResult);
+    mCurrentJob = job;
+}
+
+void RedirectMessagesJob::slotItemsReceived(const Akonadi::Item::List &items)
+{
+    mQueue += items;
+    scheduleRedirect();
+}
+
+void RedirectMessagesJob::slotFetchResult(KJob *job)
+{
+    mCurrentJob = nullptr;
+    if (mCanceled) {
+        return;
+    }
+    if (job->error()) {
+        qCWarning(KMAIL_LOG) << "Unable to fetch messages to redirect:" << job->errorString();
+        // Stop everything before reporting: the message box runs a nested event loop
+        mFetchError = job->errorString();
+        mCanceled = true;
+        mQueue.clear();
+        checkFinished();
+        return;
+    }
+    // Fetch the next chunk while this one is being redirected
+    if (mQueue.count() < sFetchChunkSize) {
+        fetchNextChunk();
+    }
+    checkFinished();
+}
+
+void RedirectMessagesJob::scheduleRedirect()
+{
+    if (mRedirectScheduled || mQueue.isEmpty()) {
+        return;
+    }
+    mRedirectScheduled = true;
+    QTimer::singleShot(0, this, &RedirectMessagesJob::redirectNextMessages);
+}
+
+void RedirectMessagesJob::redirectNextMessages()
+{
+    mRedirectScheduled = false;
+    if (mCanceled) {
+        return;
+    }
+    for (int i = 0; i < sRedirectBatchSize && !mQueue.isEmpty(); ++i) {
+        const Akonadi::Item item = mQueue.takeFirst();
+        if (!redirectMessage(item)) {
+            const KMime::Message::Ptr msg = MessageComposer::Util::message(item);
+            const QString subject = (msg && msg->subject(false)) ? msg->subject(false)->asUnicodeString() : QString();
+            mFailedMessages << (subject.isEmpty() ? i18n("(No subject)") : subject);
+        }
+        ++mProcessedItems;
+    }
+    updateProgress();
+
+    if (mQueue.count() < sFetchChunkSize) {
+        fetchNextChunk();
+    }
+    if (mQueue.isEmpty()) {
+        checkFinished();
+    } else {
+        scheduleRedirect();
+    }
+}
+
+bool RedirectMessagesJob::redirectMessage(const Akonadi::Item &item)
+{
+    const KMime::Message::Ptr msg = MessageComposer::Util::message(item);
+    if (!msg) {
+        return false;
+    }
+    MessageComposer::MessageFactoryNG factory(msg, item.id(), CommonKernel->collectionFromId(item.parentCollection().id()));
+    factory.setIdentityManager(KMKernel::self()->identityManager());
+    factory.setFolderIdentity(MailCommon::Util::folderIdentity(item));
+
+    int transportId = mSettings.mTransportId;
+    if (transportId == -1) {
+        const MailTransport::TransportAttribute *transportAttribute = item.attribute<MailTransport::TransportAttribute>();
+        if (transportAttribute) {
+            transportId = transportAttribute->transportId();
+            if (!MailTransport::TransportManager::self()->transportById(transportId)) {
+                transportId = -1;
+            }
+        }
+    }
+
+    const MailTransport::SentBehaviourAttribute *sentAttribute = item.attribute<MailTransport::SentBehaviourAttribute>();
+    QString fcc;
+    if (sentAttribute && (sentAttribute->sentBehaviour() == MailTransport::SentBehaviourAttribute::MoveToCollection)) {
+        fcc = QString::number(sentAttribute->moveToCollection().id());
+    }
+
+    const KMime::Message::Ptr newMsg = factory.createRedirect(mSettings.mTo, mSettings.mCc, mSettings.mBcc, transportId, fcc, mSettings.mIdentity);
+    if (!newMsg) {
+        return false;
+    }
+
+    Akonadi::MessageStatus status;
+    status.setStatusFromFlags(item.flags());
+    if (!status.isRead()) {
+        MailCommon::FilterAction::sendMDN(item, KMime::MDN::Dispatched);
+    }
+
+    if (!kmkernel->msgSender()->send(newMsg, mSettings.mMethod)) {
+        qCDebug(KMAIL_LOG) << "RedirectMessagesJob: could not redirect message (sending failed)";
+        return false;
+    }
+    return true;
+}
+
+void RedirectMessagesJob::slotCanceled()
+{
+    mCanceled = true;
+    mQueue.clear();
+    if (mCurrentJob) {
+        mCurrentJob->kill();
+        mCurrentJob = nullptr;
+    }
+    checkFinished();
+}
+
+void RedirectMessagesJob::updateProgress()
+{
+    if (!mProgressItem) {
+        return;
+    }
+    mProgressItem->setStatus(i18np("%2 of one message redirected", "%2 of %1 messages redirected",
+                                   mItems.count(), mProcessedItems));
+    mProgressItem->setProgress(100 * mProcessedItems / mItems.count());
+}
+
+void RedirectMessagesJob::checkFinished()
+{
+    if (mFinished || mCurrentJob) {
+        return;
+    }
+    if (!mCanceled && (mNextItem < mItems.count() || !mQueue.isEmpty())) {
+        return;
+    }
+    mFinished = true;
+
+    if (mProgressItem) {
+        mProgressItem->setComplete();
+        mProgressItem = nullptr;
+    }
+    if (!mFetchError.isEmpty()) {
+        KMessageBox::error(mParentWidget, i18n("Unable to retrieve the messages to redirect:\n%1", mFetchError));
+    }
+    if (!mFailedMessages.isEmpty()) {
+        KMessageBox::errorList(mParentWidget,
+                               i18np("One message could not be redirected:",
+                                     "%1 messages could not be redirected:", mFailedMessages.count()),
+                               mFailedMessages);
+    }
+    Q_EMIT finished(!mCanceled && mFailedMessages.isEmpty());
+    deleteLater();
+}
@@ -0,0 +1,97 @@
+/*
+   Copyright (C) 2026 KDE e.V.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+
+#ifndef REDIRECTMESSAGESJOB_H
+#define REDIRECTMESSAGESJOB_H
+
+#include <QObject>
+#include <QPointer>
+#include <QStringList>
+#include <AkonadiCore/Item>
+#include <MessageComposer/MessageSender>
+#include "kmail_export.h"
+
+class KJob;
+namespace KPIM {
+class ProgressItem;
+}
+
+struct RedirectMessagesJobSettings
+{
+    QString mTo;
+    QString mCc;
+    QString mBcc;
+    int mIdentity = 0;
+    int mTransportId = -1;
+    MessageComposer::MessageSender::SendMethod mMethod = MessageComposer::MessageSender::SendDefault;
+};
+
+/**
+ * Redirects messages without blocking the user interface.
+ *
+ * Messages are fetched in chunks, the next chunk being fetched while the
+ * current one is redirected. Redirection itself is done in small batches
+ * from the event loop, so progress is shown and the operation can be
+ * canceled. Messages which cannot be redirected are reported at the end.
+ */
+class KMAIL_EXPORT RedirectMessagesJob : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RedirectMessagesJob(QObject *parent = nullptr);
+    ~RedirectMessagesJob();
+
+    void setItems(const Akonadi::Item::List &items);
+    void setSettings(const RedirectMessagesJobSettings &settings);
+    void setParentWidget(QWidget *parentWidget);
+
+    void start();
+
+Q_SIGNALS:
+    void finished(bool success);
+
+private:
+    Q_DISABLE_COPY(RedirectMessagesJob)
+    void fetchNextChunk();
+    void slotItemsReceived(const Akonadi::Item::List &items);
+    void slotFetchResult(KJob *job);
+    void slotCanceled();
+    void redirectNextMessages();
+    bool redirectMessage(const Akonadi::Item &item);
+    void scheduleRedirect();
+    void updateProgress();
+    void checkFinished();
+
+    RedirectMessagesJobSettings mSettings;
+    Akonadi::Item::List mItems;
+    Akonadi::Item::List mQueue;
+    QStringList mFailedMessages;
+    QString mFetchError;
+    QWidget *mParentWidget = nullptr;
+    QPointer<KPIM::ProgressItem> mProgressItem;
+    KJob *mCurrentJob = nullptr;
+    int mNextItem = 0;
+    int mProcessedItems = 0;
+    bool mRedirectScheduled = false;
+    bool mCanceled = false;
+    bool mFinished = false;
+};
+
+#endif // REDIRECTMESSAGESJOB_H
@@ -18,17 +18,15 @@
 */
 
 #include "removeduplicatemailjob.h"
+#include "removeduplicatemessagesjob.h"
 
 #include "libkdepim/progressmanager.h"
 #include <KLocalizedString>
 #include <KMessageBox>
 #include <AkonadiCore/Collection>
-#include <akonadi/kmime/removeduplicatesjob.h>
 #include <AkonadiCore/EntityTreeModel>
 
 #include <QItemSelectionModel>
-Q_DECLARE_METATYPE(KPIM::ProgressItem *)
-Q_DECLARE_METATYPE(Akonadi::Job *)
 
 RemoveDuplicateMailJob::RemoveDuplicateMailJob(QItemSelectionModel *selectionModel, QWidget *widget, QObject *parent)
     : QObject(parent)
@@ -57,44 +55,40 @@ void RemoveDuplicateMailJob::start()
         }
     }
 
-    Akonadi::RemoveDuplicatesJob *job = new Akonadi::RemoveDuplicatesJob(collections, this);
-    job->setProperty("ProgressItem", QVariant::fromValue(item));
-    item->setProperty("RemoveDuplicatesJob", QVariant::fromValue(qobject_cast<Akonadi::Job *>(job)));
-    connect(job, &KJob::finished, this, &RemoveDuplicateMailJob::slotRemoveDuplicatesDone);
-    connect(job, &KJob::description, this, &RemoveDuplicateMailJob::slotRemoveDuplicatesUpdate);
+    mProgressItem = item;
+    mJob = new RemoveDuplicateMessagesJob(this);
+    mJob->setCollections(collections);
+    connect(mJob, &RemoveDuplicateMessagesJob::finished, this, &RemoveDuplicateMailJob::slotRemoveDuplicatesDone);
+    connect(mJob, &RemoveDuplicateMessagesJob::description, this, &RemoveDuplicateMailJob::slotRemoveDuplicatesUpdate);
     connect(item, &KPIM::ProgressItem::progressItemCanceled, this, &RemoveDuplicateMailJob::slotRemoveDuplicatesCanceled);
+    mJob->start();
 }
 
-void RemoveDuplicateMailJob::slotRemoveDuplicatesDone(KJob *job)
+void RemoveDuplicateMailJob::slotRemoveDuplicatesDone(bool success)
 {
-    KPIM::ProgressItem *item = job->property("ProgressItem").value<KPIM::ProgressItem *>();
-    if (item) {
-        item->setComplete();
-        item->setStatus(i18n("Done"));
-        item = nullptr;
+    if (mProgressItem) {
+        mProgressItem->setComplete();
+        mProgressItem->setStatus(i18n("Done"));
+        mProgressItem = nullptr;
     }
-    if (job->error()) {
-        KMessageBox::error(mParent, i18n("Error occurred during removing duplicate emails: \'%1\'", job->errorText()), i18n("Error while removing duplicates"));
+    if (!success) {
+        KMessageBox::error(mParent, i18n("Error occurred during removing duplicate emails: \'%1\'", mJob->errorText()), i18n("Error while removing duplicates"));
     }
     deleteLater();
 }
 
 void RemoveDuplicateMailJob::slotRemoveDuplicatesCanceled(KPIM::ProgressItem *item)
 {
-    Akonadi::Job *job = item->property("RemoveDuplicatesJob").value<Akonadi::Job *>();
-    if (job) {
-        job->kill(KJob::Quietly);
-    }
+    mJob->kill();
 
     item->setComplete();
     item = nullptr;
     deleteLater();
 }
 
-void RemoveDuplicateMailJob::slotRemoveDuplicatesUpdate(KJob *job, const QString &description)
+void RemoveDuplicateMailJob::slotRemoveDuplicatesUpdate(const QString &description)
 {
-    KPIM::ProgressItem *item = job->property("ProgressItem").value<KPIM::ProgressItem *>();
-    if (item) {
-        item->setStatus(description);
+    if (mProgressItem) {
+        mProgressItem->setStatus(description);
     }
 }
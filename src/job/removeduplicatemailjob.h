@@ -21,12 +21,13 @@
 #define REMOVEDUPLICATEMAILJOB_H
 
 #include <QObject>
+#include <QPointer>
 class QWidget;
 class QItemSelectionModel;
 namespace KPIM {
 class ProgressItem;
 }
-class KJob;
+class RemoveDuplicateMessagesJob;
 class RemoveDuplicateMailJob : public QObject
 {
     Q_OBJECT
@@ -38,11 +39,13 @@ public:
 
 private:
     Q_DISABLE_COPY(RemoveDuplicateMailJob)
-    void slotRemoveDuplicatesDone(KJob *job);
+    void slotRemoveDuplicatesDone(bool success);
     void slotRemoveDuplicatesCanceled(KPIM::ProgressItem *item);
-    void slotRemoveDuplicatesUpdate(KJob *job, const QString &description);
+    void slotRemoveDuplicatesUpdate(const QString &description);
     QWidget *mParent = nullptr;
     QItemSelectionModel *mSelectionModel = nullptr;
+    RemoveDuplicateMessagesJob *mJob = nullptr;
+    QPointer<KPIM::ProgressItem> mProgressItem;
 };
 
 #endif // REMOVEDUPLICATEMAILJOB_H
@@ -19,9 +19,9 @@
 */
 
 #include "removeduplicatemessageinfolderandsubfolderjob.h"
+#include "removeduplicatemessagesjob.h"
 #include <PimCommonAkonadi/FetchRecursiveCollectionsJob>
 #include "kmail_debug.h"
-#include <Akonadi/KMime/RemoveDuplicatesJob>
 #include "libkdepim/progressmanager.h"
 #include <KLocalizedString>
 #include <KMessageBox>
@@ -78,45 +78,41 @@ void RemoveDuplicateMessageInFolderAndSubFolderJob::slotFetchCollectionDone(cons
         item->setUsesBusyIndicator(true);
         item->setCryptoStatus(KPIM::ProgressItem::Unknown);
 
-        Akonadi::RemoveDuplicatesJob *job = new Akonadi::RemoveDuplicatesJob(lst, this);
-        job->setProperty("ProgressItem", QVariant::fromValue(item));
-        item->setProperty("RemoveDuplicatesJob", QVariant::fromValue(qobject_cast<Akonadi::Job *>(job)));
-        connect(job, &Akonadi::RemoveDuplicatesJob::finished, this, &RemoveDuplicateMessageInFolderAndSubFolderJob::slotFinished);
-        connect(job, &Akonadi::RemoveDuplicatesJob::description, this, &RemoveDuplicateMessageInFolderAndSubFolderJob::slotRemoveDuplicatesUpdate);
+        mProgressItem = item;
+        mJob = new RemoveDuplicateMessagesJob(this);
+        mJob->setCollections(lst);
+        connect(mJob, &RemoveDuplicateMessagesJob::finished, this, &RemoveDuplicateMessageInFolderAndSubFolderJob::slotFinished);
+        connect(mJob, &RemoveDuplicateMessagesJob::description, this, &RemoveDuplicateMessageInFolderAndSubFolderJob::slotRemoveDuplicatesUpdate);
         connect(item, &KPIM::ProgressItem::progressItemCanceled, this, &RemoveDuplicateMessageInFolderAndSubFolderJob::slotRemoveDuplicatesCanceled);
+        mJob->start();
     }
 }
 
-void RemoveDuplicateMessageInFolderAndSubFolderJob::slotFinished(KJob *job)
+void RemoveDuplicateMessageInFolderAndSubFolderJob::slotFinished(bool success)
 {
-    KPIM::ProgressItem *item = job->property("ProgressItem").value<KPIM::ProgressItem *>();
-    if (item) {
-        item->setComplete();
-        item->setStatus(i18n("Done"));
-        item = nullptr;
+    if (mProgressItem) {
+        mProgressItem->setComplete();
+        mProgressItem->setStatus(i18n("Done"));
+        mProgressItem = nullptr;
     }
-    if (job->error()) {
-        qCDebug(KMAIL_LOG()) << " Error during remove duplicates " << job->errorString();
-        KMessageBox::error(mParentWidget, i18n("Error occurred during removing duplicate emails: \'%1\'", job->errorText()), i18n("Error while removing duplicates"));
+    if (!success) {
+        qCDebug(KMAIL_LOG()) << " Error during remove duplicates " << mJob->errorText();
+        KMessageBox::error(mParentWidget, i18n("Error occurred during removing duplicate emails: \'%1\'", mJob->errorText()), i18n("Error while removing duplicates"));
     }
 
     deleteLater();
 }
 
-void RemoveDuplicateMessageInFolderAndSubFolderJob::slotRemoveDuplicatesUpdate(KJob *job, const QString &description)
+void RemoveDuplicateMessageInFolderAndSubFolderJob::slotRemoveDuplicatesUpdate(const QString &description)
 {
-    KPIM::ProgressItem *item = job->property("ProgressItem").value<KPIM::ProgressItem *>();
-    if (item) {
-        item->setStatus(description);
+    if (mProgressItem) {
+        mProgressItem->setStatus(description);
     }
 }
 
 void RemoveDuplicateMessageInFolderAndSubFolderJob::slotRemoveDuplicatesCanceled(KPIM::ProgressItem *item)
 {
-    Akonadi::Job *job = item->property("RemoveDuplicatesJob").value<Akonadi::Job *>();
-    if (job) {
-        job->kill(KJob::Quietly);
-    }
+    mJob->kill();
 
     item->setComplete();
     item = nullptr;
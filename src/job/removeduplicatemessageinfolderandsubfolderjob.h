@@ -22,8 +22,9 @@
 #define REMOVEDUPLICATEMESSAGEINFOLDERANDSUBFOLDERJOB_H
 
 #include <QObject>
+#include <QPointer>
 #include <AkonadiCore/Collection>
-class KJob;
+class RemoveDuplicateMessagesJob;
 namespace KPIM {
 class ProgressItem;
 }
@@ -42,11 +43,13 @@ private:
     Q_DISABLE_COPY(RemoveDuplicateMessageInFolderAndSubFolderJob)
     void slotFetchCollectionFailed();
     void slotFetchCollectionDone(const Akonadi::Collection::List &list);
-    void slotFinished(KJob *job);
-    void slotRemoveDuplicatesUpdate(KJob *job, const QString &description);
+    void slotFinished(bool success);
+    void slotRemoveDuplicatesUpdate(const QString &description);
     void slotRemoveDuplicatesCanceled(KPIM::ProgressItem *item);
     Akonadi::Collection mTopLevelCollection;
     QWidget *mParentWidget = nullptr;
+    RemoveDuplicateMessagesJob *mJob = nullptr;
+    QPointer<KPIM::ProgressItem> mProgressItem;
 };
 
 #endif // REMOVEDUPLICATEMESSAGEINFOLDERANDSUBFOLDERJOB_H
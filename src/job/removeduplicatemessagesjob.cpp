@@ -0,0 +1,350 @@
+/*
+   Copyright (C) 2026 KDE e.V.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "removeduplicatemessagesjob.h"
+#include "kmail_debug.h"
+
+#include <AkonadiCore/ItemDeleteJob>
+#include <AkonadiCore/ItemFetchJob>
+#include <AkonadiCore/ItemFetchScope>
+#include <Akonadi/KMime/MessageParts>
+#include <KLocalizedString>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+
+namespace {
+static const int sDigestCacheVersion = 2;
+static const int sPayloadFetchChunkSize = 50;
+
+QString digestCacheFileName()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QLatin1String("/kmail2/duplicatedigests");
+}
+
+QByteArray headerValue(KMime::Headers::Base *header)
+{
+    return header ? header->as7BitString(false) : QByteArray();
+}
+}
+
+RemoveDuplicateMessagesJob::RemoveDuplicateMessagesJob(QObject *parent)
+    : QObject(parent)
+{
+}
+
+RemoveDuplicateMessagesJob::~RemoveDuplicateMessagesJob()
+{
+}
+
+void RemoveDuplicateMessagesJob::setCollections(const Akonadi::Collection::List &collections)
+{
+    mCollections = collections;
+}
+
+QString RemoveDuplicateMessagesJob::errorText() const
+{
+    return mErrorText;
+}
+
+QByteArray RemoveDuplicateMessagesJob::candidateKey(const KMime::Message::Ptr &msg)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(headerValue(msg->messageID(false)));
+    hash.addData("\n", 1);
+    hash.addData(headerValue(msg->date(false)));
+    hash.addData("\n", 1);
+    hash.addData(headerValue(msg->from(false)));
+    hash.addData("\n", 1);
+    hash.addData(headerValue(msg->subject(false)));
+    return hash.result();
+}
+
+QByteArray RemoveDuplicateMessagesJob::contentDigest(const KMime::Message::Ptr &msg)
+{
+    return QCryptographicHash::hash(msg->encodedBody(), QCryptographicHash::Sha1);
+}
+
+void RemoveDuplicateMessagesJob::start()
+{
+    loadDigestCache();
+    processNextCollection();
+}
+
+void RemoveDuplicateMessagesJob::kill()
+{
+    mCanceled = true;
+    if (mCurrentJob) {
+        mCurrentJob->kill(KJob::Quietly);
+    }
+    saveDigestCache();
+}
+
+void RemoveDuplicateMessagesJob::processNextCollection()
+{
+    mGroups.clear();
+    mCollidingGroups.clear();
+    mDigests.clear();
+    mItemsToFetch.clear();
+    mItemsToDelete.clear();
+    if (mCanceled) {
+        return;
+    }
+    if (mCollections.isEmpty()) {
+        finish();
+        return;
+    }
+    mCurrentCollection = mCollections.takeFirst();
+    Q_EMIT description(i18n("Looking for duplicates in \"%1\"", mCurrentCollection.displayName()));
+
+    // Only the envelope is needed to find the candidates, and the items do
+    // not need to be kept by the job once they were grouped.
+    Akonadi::ItemFetchJob *job = new Akonadi::ItemFetchJob(mCurrentCollection, this);
+    job->setDeliveryOption(Akonadi::ItemFetchJob::EmitItemsInBatches);
+    job->fetchScope().fetchPayloadPart(Akonadi::MessagePart::Envelope);
+    job->fetchScope().setFetchModificationTime(true);
+    connect(job, &Akonadi::ItemFetchJob::itemsReceived, this, &RemoveDuplicateMessagesJob::slotEnvelopesReceived);
+    connect(job, &Akonadi::ItemFetchJob::result, this, &RemoveDuplicateMessagesJob::slotEnvelopeFetchDone);
+    mCurrentJob = job;
+}
+
+void RemoveDuplicateMessagesJob::slotEnvelopesReceived(const Akonadi::Item::List &items)
+{
+    for (const Akonadi::Item &item : items) {
+        if (mDigestCache.contains(item.id())) {
+            mSeenCachedItems.insert(item.id());
+        }
+        if (!item.hasPayload<KMime::Message::Ptr>()) {
+            continue;
+        }
+        const Candidate candidate = { item.id(), item.size(), item.modificationTime().toMSecsSinceEpoch() };
+        mGroups[candidateKey(item.payload<KMime::Message::Ptr>())].append(candidate);
+    }
+}
+
+void RemoveDuplicateMessagesJob::slotEnvelopeFetchDone(KJob *job)
+{
+    mCurrentJob = nullptr;
+    if (job->error()) {
+        qCDebug(KMAIL_LOG) << "Unable to fetch messages of" << mCurrentCollection.id() << job->errorString();
+        mErrorText = job->errorText();
+        finish();
+        return;
+    }
+    mListedCollections.insert(mCurrentCollection.id());
+
+    for (auto it = mGroups.cbegin(), end = mGroups.cend(); it != end; ++it) {
+        const QVector<Candidate> &group = it.value();
+        if (group.count() < 2) {
+            continue;
+        }
+        mCollidingGroups.append(group);
+        for (const Candidate &candidate : group) {
+            const auto cached = mDigestCache.constFind(candidate.id);
+            if (cached != mDigestCache.cend()
+                && cached->size == candidate.size
+                && cached->modificationTime == candidate.modificationTime) {
+                mDigests.insert(candidate.id, cached->digest);
+            } else {
+                mItemsToFetch.append(Akonadi::Item(candidate.id));
+            }
+        }
+    }
+    mGroups.clear();
+    fetchNextDigests();
+}
+
+void RemoveDuplicateMessagesJob::fetchNextDigests()
+{
+    if (mCanceled) {
+        return;
+    }
+    if (mItemsToFetch.isEmpty()) {
+        removeDuplicates();
+        return;
+    }
+    Q_EMIT description(i18np("Comparing one message in \"%2\"", "Comparing %1 messages in \"%2\"", mItemsToFetch.count(), mCurrentCollection.displayName()));
+
+    const int count = qMin(sPayloadFetchChunkSize, mItemsToFetch.count());
+    const Akonadi::Item::List chunk = mItemsToFetch.mid(0, count);
+    mItemsToFetch.erase(mItemsToFetch.begin(), mItemsToFetch.begin() + count);
+
+    Akonadi::ItemFetchJob *job = new Akonadi::ItemFetchJob(chunk, this);
+    job->setDeliveryOption(Akonadi::ItemFetchJob::EmitItemsInBatches);
+    job->fetchScope().fetchFullPayload();
+    job->fetchScope().setFetchModificationTime(true);
+    connect(job, &Akonadi::ItemFetchJob::itemsReceived, this, &RemoveDuplicateMessagesJob::slotPayloadsReceived);
+    connect(job, &Akonadi::ItemFetchJob::result, this, &RemoveDuplicateMessagesJob::slotPayloadFetchDone);
+    mCurrentJob = job;
+}
+
+void RemoveDuplicateMessagesJob::slotPayloadsReceived(const Akonadi::Item::List &items)
+{
+    for (const Akonadi::Item &item : items) {
+        if (!item.hasPayload<KMime::Message::Ptr>()) {
+            continue;
+        }
+        const QByteArray digest = contentDigest(item.payload<KMime::Message::Ptr>());
+        mDigests.insert(item.id(), digest);
+        const DigestCacheEntry entry = { mCurrentCollection.id(), item.size(), item.modificationTime().toMSecsSinceEpoch(), digest };
+        mDigestCache.insert(item.id(), entry);
+        mSeenCachedItems.insert(item.id());
+        mDigestCacheChanged = true;
+    }
+}
+
+void RemoveDuplicateMessagesJob::slotPayloadFetchDone(KJob *job)
+{
+    mCurrentJob = nullptr;
+    if (job->error()) {
+        // Messages which could not be fetched are simply not compared.
+        qCDebug(KMAIL_LOG) << "Unable to fetch messages" << job->errorString();
+    }
+    fetchNextDigests();
+}
+
+void RemoveDuplicateMessagesJob::removeDuplicates()
+{
+    for (QVector<Candidate> &group : mCollidingGroups) {
+        // Keep the oldest message of each set of duplicates.
+        std::sort(group.begin(), group.end(), [](const Candidate &left, const Candidate &right) {
+            return left.id < right.id;
+        });
+        QVector<QByteArray> seenDigests;
+        for (const Candidate &candidate : qAsConst(group)) {
+            const QByteArray digest = mDigests.value(candidate.id);
+            if (digest.isEmpty()) {
+                continue;
+            }
+            if (seenDigests.contains(digest)) {
+                mItemsToDelete.append(Akonadi::Item(candidate.id));
+            } else {
+                seenDigests.append(digest);
+            }
+        }
+    }
+    mCollidingGroups.clear();
+
+    if (mItemsToDelete.isEmpty()) {
+        processNextCollection();
+        return;
+    }
+    Q_EMIT description(i18np("Removing one duplicate from \"%2\"", "Removing %1 duplicates from \"%2\"", mItemsToDelete.count(), mCurrentCollection.displayName()));
+    Akonadi::ItemDeleteJob *job = new Akonadi::ItemDeleteJob(mItemsToDelete, this);
+    connect(job, &Akonadi::ItemDeleteJob::result, this, &RemoveDuplicateMessagesJob::slotDeleteDone);
+    mCurrentJob = job;
+}
+
+void RemoveDuplicateMessagesJob::slotDeleteDone(KJob *job)
+{
+    mCurrentJob = nullptr;
+    if (job->error()) {
+        qCDebug(KMAIL_LOG) << "Unable to remove duplicates" << job->errorString();
+        mErrorText = job->errorText();
+        finish();
+        return;
+    }
+    for (const Akonadi::Item &item : qAsConst(mItemsToDelete)) {
+        mDigestCache.remove(item.id());
+    }
+    mRemovedMessages += mItemsToDelete.count();
+    mDigestCacheChanged = true;
+    processNextCollection();
+}
+
+void RemoveDuplicateMessagesJob::finish()
+{
+    saveDigestCache();
+    qCDebug(KMAIL_LOG) << "Removed" << mRemovedMessages << "duplicates";
+    Q_EMIT finished(mErrorText.isEmpty());
+}
+
+void RemoveDuplicateMessagesJob::loadDigestCache()
+{
+    mDigestCache.clear();
+    QFile file(digestCacheFileName());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    qint32 version = 0;
+    qint32 count = 0;
+    stream >> version >> count;
+    if (version != sDigestCacheVersion) {
+        return;
+    }
+    // Don't trust the count for an allocation, the file might be corrupted
+    for (qint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        qint64 id;
+        DigestCacheEntry entry;
+        stream >> id >> entry.collectionId >> entry.size >> entry.modificationTime >> entry.digest;
+        mDigestCache.insert(id, entry);
+    }
+    if (stream.status() != QDataStream::Ok) {
+        qCDebug(KMAIL_LOG) << "Ignoring corrupted duplicate digest cache";
+        mDigestCache.clear();
+    }
+}
+
+void RemoveDuplicateMessagesJob::pruneDigestCache()
+{
+    // Forget the messages which are gone from the collections we went through
+    for (auto it = mDigestCache.begin(); it != mDigestCache.end();) {
+        if (mListedCollections.contains(it->collectionId) && !mSeenCachedItems.contains(it.key())) {
+            it = mDigestCache.erase(it);
+            mDigestCacheChanged = true;
+        } else {
+            ++it;
+        }
+    }
+    mListedCollections.clear();
+    mSeenCachedItems.clear();
+}
+
+void RemoveDuplicateMessagesJob::saveDigestCache()
+{
+    pruneDigestCache();
+    if (!mDigestCacheChanged) {
+        return;
+    }
+    const QString fileName = digestCacheFileName();
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCDebug(KMAIL_LOG) << "Unable to write duplicate digest cache" << fileName;
+        return;
+    }
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << qint32(sDigestCacheVersion) << qint32(mDigestCache.count());
+    for (auto it = mDigestCache.cbegin(), end = mDigestCache.cend(); it != end; ++it) {
+        stream << qint64(it.key()) << qint64(it->collectionId) << it->size << it->modificationTime << it->digest;
+    }
+    if (file.commit()) {
+        mDigestCacheChanged = false;
+    }
+}
@@ -0,0 +1,112 @@
+/*
+   Copyright (C) 2026 KDE e.V.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef REMOVEDUPLICATEMESSAGESJOB_H
+#define REMOVEDUPLICATEMESSAGESJOB_H
+
+#include <QObject>
+#include <QHash>
+#include <QPointer>
+#include <QSet>
+#include <QVector>
+#include <AkonadiCore/Collection>
+#include <AkonadiCore/Item>
+#include <KMime/Message>
+#include "kmail_export.h"
+
+class KJob;
+/**
+ * Removes duplicated messages from a list of folders.
+ *
+ * Messages are first grouped by their Message-ID, date, sender and subject,
+ * which only needs an envelope fetch. The full payload is fetched only for
+ * messages sharing a group, to compare their bodies. Body digests are kept
+ * in a cache on disk, so running the job again on the same folders does not
+ * download those messages a second time.
+ *
+ * As Akonadi::RemoveDuplicatesJob, duplicates are only looked for inside a
+ * folder, not across folders.
+ */
+class KMAIL_EXPORT RemoveDuplicateMessagesJob : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RemoveDuplicateMessagesJob(QObject *parent = nullptr);
+    ~RemoveDuplicateMessagesJob();
+
+    void setCollections(const Akonadi::Collection::List &collections);
+
+    void start();
+    void kill();
+
+    QString errorText() const;
+
+    static QByteArray candidateKey(const KMime::Message::Ptr &msg);
+    static QByteArray contentDigest(const KMime::Message::Ptr &msg);
+
+Q_SIGNALS:
+    void description(const QString &text);
+    void finished(bool success);
+
+private:
+    Q_DISABLE_COPY(RemoveDuplicateMessagesJob)
+    struct Candidate {
+        Akonadi::Item::Id id;
+        qint64 size;
+        qint64 modificationTime;
+    };
+    struct DigestCacheEntry {
+        Akonadi::Collection::Id collectionId;
+        qint64 size;
+        qint64 modificationTime;
+        QByteArray digest;
+    };
+
+    void processNextCollection();
+    void slotEnvelopesReceived(const Akonadi::Item::List &items);
+    void slotEnvelopeFetchDone(KJob *job);
+    void fetchNextDigests();
+    void slotPayloadsReceived(const Akonadi::Item::List &items);
+    void slotPayloadFetchDone(KJob *job);
+    void removeDuplicates();
+    void slotDeleteDone(KJob *job);
+    void finish();
+    void loadDigestCache();
+    void saveDigestCache();
+    void pruneDigestCache();
+
+    Akonadi::Collection::List mCollections;
+    Akonadi::Collection mCurrentCollection;
+    QHash<QByteArray, QVector<Candidate> > mGroups;
+    QVector<QVector<Candidate> > mCollidingGroups;
+    QHash<Akonadi::Item::Id, QByteArray> mDigests;
+    Akonadi::Item::List mItemsToFetch;
+    Akonadi::Item::List mItemsToDelete;
+    QHash<Akonadi::Item::Id, DigestCacheEntry> mDigestCache;
+    // Cached items still found in the collections listed completely
+    QSet<Akonadi::Item::Id> mSeenCachedItems;
+    QSet<Akonadi::Collection::Id> mListedCollections;
+    QPointer<KJob> mCurrentJob;
+    QString mErrorText;
+    int mRemovedMessages = 0;
+    bool mDigestCacheChanged = false;
+    bool mCanceled = false;
+};
+
+#endif // REMOVEDUPLICATEMESSAGESJOB_H
@@ -0,0 +1,253 @@
+/*
+   Copyright (C) 2026 KDE e.V.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "savemessagesinmboxjob.h"
+#include "kmail_debug.h"
+
+#include <Libkdepim/ProgressManager>
+#include <AkonadiCore/ItemFetchJob>
+#include <AkonadiCore/ItemFetchScope>
+#include <KIO/FileCopyJob>
+#include <KIO/Global>
+#include <KJobWidgets>
+#include <KLocalizedString>
+#include <KMessageBox>
+
+#include <QLocale>
+#include <QSaveFile>
+#include <QTemporaryFile>
+
+namespace {
+// Number of messages kept in memory at the same time
+static const int sFetchChunkSize = 20;
+}
+
+SaveMessagesInMboxJob::SaveMessagesInMboxJob(QObject *parent)
+    : QObject(parent)
+{
+}
+
+SaveMessagesInMboxJob::~SaveMessagesInMboxJob()
+{
+    delete mFile;
+}
+
+void SaveMessagesInMboxJob::setItems(const Akonadi::Item::List &items)
+{
+    mItems = items;
+}
+
+void SaveMessagesInMboxJob::setUrl(const QUrl &url)
+{
+    mUrl = url;
+}
+
+void SaveMessagesInMboxJob::setParentWidget(QWidget *parentWidget)
+{
+    mParentWidget = parentWidget;
+}
+
+QByteArray SaveMessagesInMboxJob::mboxMessageSeparator(const KMime::Message::Ptr &msg)
+{
+    QByteArray separator = "From ";
+    const KMime::Headers::From *from = msg->from(false);
+    if (!from || from->addresses().isEmpty()) {
+        separator += "unknown@unknown.invalid ";
+    } else {
+        separator += from->addresses().constFirst() + ' ';
+    }
+    const KMime::Headers::Date *date = msg->date(false);
+    if (!date || date->isEmpty()) {
+        separator += QLocale::c().toString(QDateTime::currentDateTime(), QStringLiteral("ddd MMM dd HH:mm:ss yyyy")).toUtf8();
+    } else {
+        separator += QLocale::c().toString(date->dateTime(), QStringLiteral("ddd MMM dd HH:mm:ss yyyy")).toUtf8();
+    }
+    separator += '\n';
+    return separator;
+}
+
+QByteArray SaveMessagesInMboxJob::escapeFrom(const QByteArray &content)
+{
+    // mboxrd: quote every line starting with any number of '>' followed by "From "
+    QByteArray result;
+    result.reserve(content.size());
+    int lineStart = 0;
+    const int size = content.size();
+    while (lineStart < size) {
+        int lineEnd = content.indexOf('\n', lineStart);
+        if (lineEnd == -1) {
+            lineEnd = size;
+        } else {
+            ++lineEnd;
+        }
+        int pos = lineStart;
+        while (pos < lineEnd && content.at(pos) == '>') {
+            ++pos;
+        }
+        if (lineEnd - pos >= 5 && qstrncmp(content.constData() + pos, "From ", 5) == 0) {
+            result += '>';
+        }
+        result.append(content.constData() + lineStart, lineEnd - lineStart);
+        lineStart = lineEnd;
+    }
+    return result;
+}
+
+void SaveMessagesInMboxJob::start()
+{
+    if (mItems.isEmpty() || mUrl.isEmpty()) {
+        finish(true);
+        return;
+    }
+
+    if (mUrl.isLocalFile()) {
+        mFile = new QSaveFile(mUrl.toLocalFile());
+    } else {
+        // Remote files are uploaded once the export is complete
+        mFile = new QTemporaryFile;
+    }
+    if (!mFile->open(QIODevice::WriteOnly)) {
+        KMessageBox::error(mParentWidget, i18n("Could not write to the file %1:\n%2", mUrl.toDisplayString(), mFile->errorString()));
+        finish(false);
+        return;
+    }
+
+    mProgressItem = KPIM::ProgressManager::createProgressItem(QLatin1String("savembox") + KPIM::ProgressManager::getUniqueID(),
+                                                              i18n("Saving messages"), QString(), true, KPIM::ProgressItem::Unknown);
+    connect(mProgressItem.data(), &KPIM::ProgressItem::progressItemCanceled,
+            this, &SaveMessagesInMboxJob::slotCanceled);
+    updateProgress();
+    fetchNextChunk();
+}
+
+void SaveMessagesInMboxJob::fetchNextChunk()
+{
+    if (mNextItem >= mItems.count()) {
+        if (mUrl.isLocalFile()) {
+            finish(static_cast<QSaveFile *>(mFile)->commit());
+        } else {
+            mFile->close();
+            KIO::FileCopyJob *job = KIO::file_copy(QUrl::fromLocalFile(mFile->fileName()), mUrl, -1, KIO::Overwrite);
+            KJobWidgets::setWindow(job, mParentWidget);
+            connect(job, &KJob::result, this, &SaveMessagesInMboxJob::slotUploadResult);
+            mCurrentJob = job;
+        }
+        return;
+    }
+
+    const Akonadi::Item::List chunk = mItems.mid(mNextItem, sFetchChunkSize);
+    mNextItem += chunk.count();
+
+    Akonadi::ItemFetchJob *job = new Akonadi::ItemFetchJob(chunk, this);
+    job->fetchScope().fetchFullPayload(true);
+    connect(job, &Akonadi::ItemFetchJob::itemsReceived, this, &SaveMessagesInMboxJob::slotItemsReceived);
+    connect(job, &KJob::result, this, &SaveMessagesInMboxJob::slotFetchResult);
+    mCurrentJob = job;
+}
+
+void SaveMessagesInMboxJob::slotItemsReceived(const Akonadi::Item::List &items)
+{
+    for (const Akonadi::Item &item : items) {
+        if (mCanceled || mWriteError) {
+            return;
+        }
+        if (item.hasPayload<KMime::Message::Ptr>()) {
+            writeMessage(item.payload<KMime::Message::Ptr>());
+        }
+    }
+    updateProgress();
+}
+
+void SaveMessagesInMboxJob::writeMessage(const KMime::Message::Ptr &msg)
+{
+    QByteArray content = msg->encodedContent();
+    if (!content.endsWith('\n')) {
+        content += '\n';
+    }
+    const QByteArray data = mboxMessageSeparator(msg) + escapeFrom(content) + '\n';
+    if (mFile->write(data) != data.size()) {
+        mWriteError = true;
+        return;
+    }
+    mBytesWritten += data.size();
+    ++mMessagesWritten;
+}
+
+void SaveMessagesInMboxJob::slotFetchResult(KJob *job)
+{
+    mCurrentJob = nullptr;
+    if (mCanceled) {
+        return;
+    }
+    if (job->error()) {
+        qCWarning(KMAIL_LOG) << "Unable to fetch messages:" << job->errorString();
+        KMessageBox::error(mParentWidget, i18n("Unable to retrieve the messages to save:\n%1", job->errorString()));
+        finish(false);
+        return;
+    }
+    if (mWriteError) {
+        KMessageBox::error(mParentWidget, i18n("Could not write to the file %1:\n%2", mUrl.toDisplayString(), mFile->errorString()));
+        finish(false);
+        return;
+    }
+    fetchNextChunk();
+}
+
+void SaveMessagesInMboxJob::slotUploadResult(KJob *job)
+{
+    mCurrentJob = nullptr;
+    if (job->error()) {
+        qCWarning(KMAIL_LOG) << "Unable to upload mbox file:" << job->errorString();
+    }
+    finish(!job->error());
+}
+
+void SaveMessagesInMboxJob::slotCanceled()
+{
+    mCanceled = true;
+    if (mCurrentJob) {
+        mCurrentJob->kill();
+        mCurrentJob = nullptr;
+    }
+    finish(false);
+}
+
+void SaveMessagesInMboxJob::updateProgress()
+{
+    if (!mProgressItem) {
+        return;
+    }
+    mProgressItem->setStatus(i18np("%2 of one message saved (%3)", "%2 of %1 messages saved (%3)",
+                                   mItems.count(), mMessagesWritten, KIO::convertSize(mBytesWritten)));
+    mProgressItem->setProgress(100 * mMessagesWritten / mItems.count());
+}
+
+void SaveMessagesInMboxJob::finish(bool success)
+{
+    if (mFile && !success && mUrl.isLocalFile()) {
+        // Don't leave a truncated mbox behind
+        static_cast<QSaveFile *>(mFile)->cancelWriting();
+    }
+    if (mProgressItem) {
+        mProgressItem->setComplete();
+        mProgressItem = nullptr;
+    }
+    Q_EMIT finished(success);
+    deleteLater();
+}
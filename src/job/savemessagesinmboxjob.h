@@ -0,0 +1,85 @@
+/*
+   Copyright (C) 2026 KDE e.V.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef SAVEMESSAGESINMBOXJOB_H
+#define SAVEMESSAGESINMBOXJOB_H
+
+#include <QObject>
+#include <QPointer>
+#include <QUrl>
+#include <AkonadiCore/Item>
+#include <KMime/Message>
+#include "kmail_export.h"
+
+class QFileDevice;
+class KJob;
+namespace KPIM {
+class ProgressItem;
+}
+/**
+ * Exports messages to a mbox file without holding them all in memory.
+ *
+ * Messages are fetched in small chunks and each one is written to the file
+ * as soon as it arrives, so memory usage does not depend on the size of the
+ * export.
+ */
+class KMAIL_EXPORT SaveMessagesInMboxJob : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SaveMessagesInMboxJob(QObject *parent = nullptr);
+    ~SaveMessagesInMboxJob();
+
+    void setItems(const Akonadi::Item::List &items);
+    void setUrl(const QUrl &url);
+    void setParentWidget(QWidget *parentWidget);
+
+    void start();
+
+    static QByteArray mboxMessageSeparator(const KMime::Message::Ptr &msg);
+    static QByteArray escapeFrom(const QByteArray &content);
+
+Q_SIGNALS:
+    void finished(bool success);
+
+private:
+    Q_DISABLE_COPY(SaveMessagesInMboxJob)
+    void fetchNextChunk();
+    void slotItemsReceived(const Akonadi::Item::List &items);
+    void slotFetchResult(KJob *job);
+    void slotUploadResult(KJob *job);
+    void slotCanceled();
+    void writeMessage(const KMime::Message::Ptr &msg);
+    void updateProgress();
+    void finish(bool success);
+
+    Akonadi::Item::List mItems;
+    QUrl mUrl;
+    QWidget *mParentWidget = nullptr;
+    QFileDevice *mFile = nullptr;
+    QPointer<KPIM::ProgressItem> mProgressItem;
+    KJob *mCurrentJob = nullptr;
+    qint64 mBytesWritten = 0;
+    int mNextItem = 0;
+    int mMessagesWritten = 0;
+    bool mCanceled = false;
+    bool mWriteError = false;
+};
+
+#endif // SAVEMESSAGESINMBOXJOB_H
@@ -52,6 +52,10 @@
 
 #include "job/createreplymessagejob.h"
 #include "job/createforwardmessagejob.h"
+#include "job/savemessagesinmboxjob.h"
+#include "job/forwardattachedmessagesjob.h"
+#include "job/redirectmessagesjob.h"
+#include "job/printmessagesjob.h"
 
 #include "editor/composer.h"
 #include "kmmainwidget.h"
@@ -68,6 +72,7 @@
 #include <AkonadiCore/ItemCopyJob>
 #include <AkonadiCore/ItemDeleteJob>
 #include <AkonadiCore/ItemCreateJob>
+#include <AkonadiCore/TransactionSequence>
 #include <AkonadiCore/Tag>
 #include <AkonadiCore/TagCreateJob>
 
@@ -79,7 +84,6 @@
 #include <MailCommon/MDNStateAttribute>
 #include <MailCommon/MailKernel>
 #include <MailCommon/MailUtil>
-#include <MailCommon/CryptoUtils>
 
 #include <MessageCore/MessageCoreSettings>
 #include <MessageCore/StringUtil>
@@ -112,6 +116,9 @@
 #endif
 
 #include <gpgme++/error.h>
+#include <gpgme++/decryptionresult.h>
+#include <QGpgME/Protocol>
+#include <QGpgME/DecryptJob>
 
 #include <KBookmarkManager>
 
@@ -134,6 +141,7 @@
 #include <QList>
 #include <QProgressDialog>
 #include <QStandardPaths>
+#include <QTimer>
 
 using KMail::SecondaryWindow;
 using MailTransport::TransportManager;
@@ -699,7 +707,9 @@ KMCommand::Result KMUseTemplateCommand::execute()
 KMSaveMsgCommand::KMSaveMsgCommand(QWidget *parent, const Akonadi::Item::List &msgList)
     : KMCommand(parent, msgList)
 {
-    if (msgList.empty()) {
+    // Several messages are streamed to the file by SaveMessagesInMboxJob,
+    // don't retrieve all of them at once
+    if (msgList.count() != 1) {
         return;
     }
 
@@ -708,9 +718,36 @@ KMSaveMsgCommand::KMSaveMsgCommand(QWidget *parent, const Akonadi::Item::List &m
 
 KMCommand::Result KMSaveMsgCommand::execute()
 {
-    if (!MessageViewer::Util::saveMessageInMbox(retrievedMsgs(), parentWidget())) {
-        return Failed;
+    const Akonadi::Item::List msgs = retrievedMsgs();
+    if (msgs.count() == 1) {
+        if (!MessageViewer::Util::saveMessageInMbox(msgs, parentWidget())) {
+            return Failed;
+        }
+        return OK;
+    }
+    if (msgs.isEmpty()) {
+        return OK;
+    }
+
+    const QString filter = i18n("email messages (*.mbox);;all files (*)");
+    const QUrl url = QFileDialog::getSaveFileUrl(parentWidget(), i18np("Save Message", "Save Messages", msgs.count()),
+                                                 QUrl::fromLocalFile(i18n("messages") + QLatin1String(".mbox")), filter);
+    if (url.isEmpty()) {
+        return Canceled;
     }
+
+    setDeletesItself(true);
+    setEmitsCompletedItself(true);
+    SaveMessagesInMboxJob *job = new SaveMessagesInMboxJob(this);
+    job->setItems(msgs);
+    job->setUrl(url);
+    job->setParentWidget(parentWidget());
+    connect(job, &SaveMessagesInMboxJob::finished, this, [this](bool success) {
+        setResult(success ? OK : Failed);
+        Q_EMIT completed(this);
+        deleteLater();
+    });
+    job->start();
     return OK;
 }
 
@@ -889,8 +926,11 @@ KMForwardCommand::KMForwardCommand(QWidget *parent, const Akonadi::Item::List &m
     , mTemplate(templateName)
     , mSelection(selection)
 {
-    fetchScope().fetchFullPayload(true);
-    fetchScope().setAncestorRetrieval(Akonadi::ItemFetchScope::Parent);
+    // Several messages are only fetched once we know how to forward them
+    if (msgList.count() < 2) {
+        fetchScope().fetchFullPayload(true);
+        fetchScope().setAncestorRetrieval(Akonadi::ItemFetchScope::Parent);
+    }
 }
 
 KMForwardCommand::KMForwardCommand(QWidget *parent, const Akonadi::Item &msg, uint identity, const QString &templateName, const QString &selection)
@@ -942,27 +982,39 @@ KMCommand::Result KMForwardCommand::execute()
             KGuiItem(i18n("Send Individually")));
 
         if (answer == KMessageBox::Yes) {
-            Akonadi::Item firstItem(msgList.first());
-            MessageFactoryNG factory(KMime::Message::Ptr(new KMime::Message), firstItem.id(),
-                                     CommonKernel->collectionFromId(firstItem.parentCollection().id()));
-            factory.setIdentityManager(KMKernel::self()->identityManager());
-            factory.setFolderIdentity(MailCommon::Util::folderIdentity(firstItem));
-
-            QPair< KMime::Message::Ptr, KMime::Content * > fwdMsg = factory.createForwardDigestMIME(msgList);
-            KMail::Composer *win = KMail::makeComposer(fwdMsg.first, false, false, KMail::Composer::Forward, mIdentity);
-            win->addAttach(fwdMsg.second);
-            win->show();
-            delete fwdMsg.second;
+            setDeletesItself(true);
+            setEmitsCompletedItself(true);
+            ForwardAttachedMessagesJob *job = new ForwardAttachedMessagesJob(this);
+            job->setItems(msgList);
+            job->setMode(ForwardAttachedMessagesJob::Digest);
+            job->setIdentity(mIdentity);
+            connect(job, &ForwardAttachedMessagesJob::finished, this, [this](bool success) {
+                setResult(success ? OK : Failed);
+                Q_EMIT completed(this);
+                deleteLater();
+            });
+            job->start();
             return OK;
         } else if (answer == KMessageBox::No) {  // NO MIME DIGEST, Multiple forward
-            Akonadi::Item::List::const_iterator it;
-            Akonadi::Item::List::const_iterator end(msgList.constEnd());
-
-            for (it = msgList.constBegin(); it != end; ++it) {
-                if (createComposer(*it) == Failed) {
-                    return Failed;
+            // Open each composer as soon as its message arrives
+            setDeletesItself(true);
+            setEmitsCompletedItself(true);
+            Akonadi::ItemFetchJob *job = new Akonadi::ItemFetchJob(msgList, this);
+            job->fetchScope().fetchFullPayload(true);
+            job->fetchScope().setAncestorRetrieval(Akonadi::ItemFetchScope::Parent);
+            connect(job, &Akonadi::ItemFetchJob::itemsReceived, this, [this](const Akonadi::Item::List &items) {
+                for (const Akonadi::Item &item : items) {
+                    createComposer(item);
                 }
-            }
+            });
+            connect(job, &KJob::result, this, [this](KJob *job) {
+                if (job->error()) {
+                    showJobError(job);
+                }
+                setResult(job->error() ? Failed : OK);
+                Q_EMIT completed(this);
+                deleteLater();
+            });
             return OK;
         } else {
             // user cancelled
@@ -983,8 +1035,7 @@ KMForwardAttachedCommand::KMForwardAttachedCommand(QWidget *parent, const Akonad
     , mIdentity(identity)
     , mWin(QPointer<KMail::Composer>(win))
 {
-    fetchScope().fetchFullPayload(true);
-    fetchScope().setAncestorRetrieval(Akonadi::ItemFetchScope::Parent);
+    // ForwardAttachedMessagesJob fetches the messages in chunks
 }
 
 KMForwardAttachedCommand::KMForwardAttachedCommand(QWidget *parent, const Akonadi::Item &msg, uint identity, KMail::Composer *win)
@@ -992,49 +1043,39 @@ KMForwardAttachedCommand::KMForwardAttachedCommand(QWidget *parent, const Akonad
     , mIdentity(identity)
     , mWin(QPointer< KMail::Composer >(win))
 {
-    fetchScope().fetchFullPayload(true);
-    fetchScope().setAncestorRetrieval(Akonadi::ItemFetchScope::Parent);
 }
 
 KMCommand::Result KMForwardAttachedCommand::execute()
 {
-    Akonadi::Item::List msgList = retrievedMsgs();
-    Akonadi::Item firstItem(msgList.first());
-    MessageFactoryNG factory(KMime::Message::Ptr(new KMime::Message), firstItem.id(),
-                             CommonKernel->collectionFromId(firstItem.parentCollection().id()));
-    factory.setIdentityManager(KMKernel::self()->identityManager());
-    factory.setFolderIdentity(MailCommon::Util::folderIdentity(firstItem));
-
-    QPair< KMime::Message::Ptr, QList< KMime::Content * > > fwdMsg = factory.createAttachedForward(msgList);
-    if (!mWin) {
-        mWin = KMail::makeComposer(fwdMsg.first, false, false, KMail::Composer::Forward, mIdentity);
-    }
-    for (KMime::Content *attach : qAsConst(fwdMsg.second)) {
-        mWin->addAttach(attach);
-        delete attach;
+    const Akonadi::Item::List msgList = retrievedMsgs();
+    if (msgList.isEmpty()) {
+        return Failed;
     }
-    mWin->show();
+    setDeletesItself(true);
+    setEmitsCompletedItself(true);
+    ForwardAttachedMessagesJob *job = new ForwardAttachedMessagesJob(this);
+    job->setItems(msgList);
+    job->setMode(ForwardAttachedMessagesJob::Attached);
+    job->setIdentity(mIdentity);
+    job->setComposer(mWin);
+    connect(job, &ForwardAttachedMessagesJob::finished, this, [this](bool success) {
+        setResult(success ? OK : Failed);
+        Q_EMIT completed(this);
+        deleteLater();
+    });
+    job->start();
     return OK;
 }
 
 KMRedirectCommand::KMRedirectCommand(QWidget *parent, const Akonadi::Item::List &msgList)
     : KMCommand(parent, msgList)
 {
-    fetchScope().fetchFullPayload(true);
-    fetchScope().fetchAttribute<MailTransport::SentBehaviourAttribute>();
-    fetchScope().fetchAttribute<MailTransport::TransportAttribute>();
-
-    fetchScope().setAncestorRetrieval(Akonadi::ItemFetchScope::Parent);
+    // RedirectMessagesJob fetches the messages in chunks
 }
 
 KMRedirectCommand::KMRedirectCommand(QWidget *parent, const Akonadi::Item &msg)
     : KMCommand(parent, msg)
 {
-    fetchScope().fetchFullPayload(true);
-    fetchScope().fetchAttribute<MailTransport::SentBehaviourAttribute>();
-    fetchScope().fetchAttribute<MailTransport::TransportAttribute>();
-
-    fetchScope().setAncestorRetrieval(Akonadi::ItemFetchScope::Parent);
 }
 
 KMCommand::Result KMRedirectCommand::execute()
@@ -1057,55 +1098,26 @@ KMCommand::Result KMRedirectCommand::execute()
                                                               ? MessageComposer::MessageSender::SendImmediate
                                                               : MessageComposer::MessageSender::SendLater;
 
-    const int identity = dlg->identity();
-    int transportId = dlg->transportId();
-    const QString to = dlg->to();
-    const QString cc = dlg->cc();
-    const QString bcc = dlg->bcc();
-    const Akonadi::Item::List lstItems = retrievedMsgs();
-    for (const Akonadi::Item &item : lstItems) {
-        const KMime::Message::Ptr msg = MessageComposer::Util::message(item);
-        if (!msg) {
-            return Failed;
-        }
-        MessageFactoryNG factory(msg, item.id(), CommonKernel->collectionFromId(item.parentCollection().id()));
-        factory.setIdentityManager(KMKernel::self()->identityManager());
-        factory.setFolderIdentity(MailCommon::Util::folderIdentity(item));
-
-        if (transportId == -1) {
-            const MailTransport::TransportAttribute *transportAttribute = item.attribute<MailTransport::TransportAttribute>();
-            if (transportAttribute) {
-                transportId = transportAttribute->transportId();
-                const MailTransport::Transport *transport = MailTransport::TransportManager::self()->transportById(transportId);
-                if (!transport) {
-                    transportId = -1;
-                }
-            }
-        }
-
-        const MailTransport::SentBehaviourAttribute *sentAttribute = item.attribute<MailTransport::SentBehaviourAttribute>();
-        QString fcc;
-        if (sentAttribute && (sentAttribute->sentBehaviour() == MailTransport::SentBehaviourAttribute::MoveToCollection)) {
-            fcc = QString::number(sentAttribute->moveToCollection().id());
-        }
-
-        const KMime::Message::Ptr newMsg = factory.createRedirect(to, cc, bcc, transportId, fcc, identity);
-        if (!newMsg) {
-            return Failed;
-        }
-
-        MessageStatus status;
-        status.setStatusFromFlags(item.flags());
-        if (!status.isRead()) {
-            FilterAction::sendMDN(item, KMime::MDN::Dispatched);
-        }
-
-        if (!kmkernel->msgSender()->send(newMsg, method)) {
-            qCDebug(KMAIL_LOG) << "KMRedirectCommand: could not redirect message (sending failed)";
-            return Failed; // error: couldn't send
-        }
-    }
+    RedirectMessagesJobSettings settings;
+    settings.mIdentity = dlg->identity();
+    settings.mTransportId = dlg->transportId();
+    settings.mTo = dlg->to();
+    settings.mCc = dlg->cc();
+    settings.mBcc = dlg->bcc();
+    settings.mMethod = method;
 
+    setDeletesItself(true);
+    setEmitsCompletedItself(true);
+    RedirectMessagesJob *job = new RedirectMessagesJob(this);
+    job->setItems(retrievedMsgs());
+    job->setSettings(settings);
+    job->setParentWidget(parentWidget());
+    connect(job, &RedirectMessagesJob::finished, this, [this](bool success) {
+        setResult(success ? OK : Failed);
+        Q_EMIT completed(this);
+        deleteLater();
+    });
+    job->start();
     return OK;
 }
 
@@ -1114,6 +1126,22 @@ KMPrintCommand::KMPrintCommand(QWidget *parent, const KMPrintCommandInfo &comman
     , mPrintCommandInfo(commandInfo)
 {
     fetchScope().fetchFullPayload(true);
+    initOverrideFont();
+}
+
+KMPrintCommand::KMPrintCommand(QWidget *parent, const Akonadi::Item::List &msgList, const KMPrintCommandInfo &commandInfo)
+    : KMCommand(parent, msgList)
+    , mPrintCommandInfo(commandInfo)
+{
+    // Several messages are fetched batch by batch by PrintMessagesJob
+    if (msgList.count() < 2) {
+        fetchScope().fetchFullPayload(true);
+    }
+    initOverrideFont();
+}
+
+void KMPrintCommand::initOverrideFont()
+{
     if (MessageCore::MessageCoreSettings::useDefaultFonts()) {
         mPrintCommandInfo.mOverrideFont = QFontDatabase::systemFont(QFontDatabase::GeneralFont);
     } else {
@@ -1121,26 +1149,48 @@ KMPrintCommand::KMPrintCommand(QWidget *parent, const KMPrintCommandInfo &comman
     }
 }
 
-KMCommand::Result KMPrintCommand::execute()
+KMReaderWin *KMPrintCommand::createPrinterWin(const KMPrintCommandInfo &commandInfo)
 {
     KMReaderWin *printerWin = new KMReaderWin(nullptr, kmkernel->mainWin(), nullptr);
     printerWin->setPrinting(true);
     printerWin->readConfig();
     printerWin->setPrintElementBackground(MessageViewer::MessageViewerSettings::self()->printBackgroundColorImages());
-    if (mPrintCommandInfo.mHeaderStylePlugin) {
-        printerWin->viewer()->setPluginName(mPrintCommandInfo.mHeaderStylePlugin->name());
-    }
-    printerWin->setDisplayFormatMessageOverwrite(mPrintCommandInfo.mFormat);
-    printerWin->setHtmlLoadExtOverride(mPrintCommandInfo.mHtmlLoadExtOverride);
-    printerWin->setUseFixedFont(mPrintCommandInfo.mUseFixedFont);
-    printerWin->setOverrideEncoding(mPrintCommandInfo.mEncoding);
-    printerWin->cssHelper()->setPrintFont(mPrintCommandInfo.mOverrideFont);
+    if (commandInfo.mHeaderStylePlugin) {
+        printerWin->viewer()->setPluginName(commandInfo.mHeaderStylePlugin->name());
+    }
+    printerWin->setDisplayFormatMessageOverwrite(commandInfo.mFormat);
+    printerWin->setHtmlLoadExtOverride(commandInfo.mHtmlLoadExtOverride);
+    printerWin->setUseFixedFont(commandInfo.mUseFixedFont);
+    printerWin->setOverrideEncoding(commandInfo.mEncoding);
+    printerWin->cssHelper()->setPrintFont(commandInfo.mOverrideFont);
     printerWin->setDecryptMessageOverwrite(true);
-    if (mPrintCommandInfo.mAttachmentStrategy) {
-        printerWin->setAttachmentStrategy(mPrintCommandInfo.mAttachmentStrategy);
+    if (commandInfo.mAttachmentStrategy) {
+        printerWin->setAttachmentStrategy(commandInfo.mAttachmentStrategy);
     }
-    printerWin->viewer()->setShowSignatureDetails(mPrintCommandInfo.mShowSignatureDetails);
-    printerWin->viewer()->setShowEncryptionDetails(mPrintCommandInfo.mShowEncryptionDetails);
+    printerWin->viewer()->setShowSignatureDetails(commandInfo.mShowSignatureDetails);
+    printerWin->viewer()->setShowEncryptionDetails(commandInfo.mShowEncryptionDetails);
+    return printerWin;
+}
+
+KMCommand::Result KMPrintCommand::execute()
+{
+    const Akonadi::Item::List msgList = retrievedMsgs();
+    if (msgList.count() > 1) {
+        setDeletesItself(true);
+        setEmitsCompletedItself(true);
+        PrintMessagesJob *job = new PrintMessagesJob(this);
+        job->setItems(msgList);
+        job->setPrintCommandInfo(mPrintCommandInfo);
+        connect(job, &PrintMessagesJob::finished, this, [this](bool success) {
+            setResult(success ? OK : Failed);
+            Q_EMIT completed(this);
+            deleteLater();
+        });
+        job->start();
+        return OK;
+    }
+
+    KMReaderWin *printerWin = createPrinterWin(mPrintCommandInfo);
     if (mPrintCommandInfo.mPrintPreview) {
         printerWin->viewer()->printPreviewMessage(retrievedMessage());
     } else {
@@ -1391,6 +1441,11 @@ KMCommand::Result KMMailingListFilterCommand::execute()
     }
 }
 
+namespace {
+// Number of messages copied, moved, trashed or deleted by one Akonadi job
+static const int sMoveChunkSize = 1000;
+}
+
 KMCopyCommand::KMCopyCommand(const Akonadi::Collection &destFolder, const Akonadi::Item::List &msgList)
     : KMCommand(nullptr, msgList)
     , mDestFolder(destFolder)
@@ -1407,33 +1462,125 @@ KMCommand::Result KMCopyCommand::execute()
 {
     setDeletesItself(true);
 
-    Akonadi::Item::List listItem = retrievedMsgs();
-    Akonadi::ItemCopyJob *job = new Akonadi::ItemCopyJob(listItem, Akonadi::Collection(mDestFolder.id()), this);
-    connect(job, &KIO::Job::result, this, &KMCopyCommand::slotCopyResult);
+    mItems = retrievedMsgs();
+    if (mItems.isEmpty()) {
+        deleteLater();
+        return Failed;
+    }
+    copyNextChunk();
 
     return OK;
 }
 
+void KMCopyCommand::copyNextChunk()
+{
+    // One chunk at a time, so that nothing needs to be killed after an error
+    const Akonadi::Item::List chunk = mItems.mid(mNextItem, sMoveChunkSize);
+    mNextItem += chunk.count();
+    Akonadi::ItemCopyJob *job = new Akonadi::ItemCopyJob(chunk, Akonadi::Collection(mDestFolder.id()), this);
+    connect(job, &KIO::Job::result, this, &KMCopyCommand::slotCopyResult);
+}
+
 void KMCopyCommand::slotCopyResult(KJob *job)
 {
     if (job->error()) {
         // handle errors
         showJobError(job);
         setResult(Failed);
+    } else if (mNextItem < mItems.count()) {
+        copyNextChunk();
+        return;
     }
 
-    qobject_cast<Akonadi::ItemCopyJob *>(job);
-
     Q_EMIT completed(this);
     deleteLater();
 }
 
+namespace {
+// Number of decrypted messages written to Akonadi in one transaction
+static const int sDecryptedItemsBatchSize = 50;
+// Stop decrypting while that many transactions are still running
+static const int sMaxPendingTransactions = 4;
+// Number of messages handed to the crypto backend at the same time
+static const int sMaxRunningDecryptions = 4;
+
+struct EncryptedData {
+    const QGpgME::Protocol *protocol = nullptr;
+    QByteArray cipherText;
+    bool inlinePGP = false;
+};
+
+EncryptedData encryptedData(const KMime::Message::Ptr &msg)
+{
+    EncryptedData data;
+    const KMime::Headers::ContentType *ct = msg->contentType(false);
+    if (ct && ct->isMimeType("multipart/encrypted")) {
+        // RFC 3156: the second part holds the encrypted data
+        const auto contents = msg->contents();
+        if (ct->parameter(QStringLiteral("protocol")).compare(QLatin1String("application/pgp-encrypted"), Qt::CaseInsensitive) == 0
+            && contents.count() == 2) {
+            data.protocol = QGpgME::openpgp();
+            data.cipherText = contents.at(1)->decodedContent();
+        }
+    } else if (ct && (ct->isMimeType("application/pkcs7-mime") || ct->isMimeType("application/x-pkcs7-mime"))) {
+        const QString smimeType = ct->parameter(QStringLiteral("smime-type"));
+        if (smimeType.isEmpty() || smimeType.compare(QLatin1String("enveloped-data"), Qt::CaseInsensitive) == 0) {
+            data.protocol = QGpgME::smime();
+            data.cipherText = msg->decodedContent();
+        }
+    } else if (!ct || ct->isPlainText()) {
+        if (msg->body().trimmed().startsWith("-----BEGIN PGP MESSAGE-----")) {
+            data.protocol = QGpgME::openpgp();
+            data.cipherText = msg->decodedContent();
+            data.inlinePGP = true;
+        }
+    }
+    return data;
+}
+
+// Puts the headers of @p msg around the decrypted @p plainText
+KMime::Message::Ptr assembleDecryptedMessage(const KMime::Message::Ptr &msg, const QByteArray &plainText, bool inlinePGP)
+{
+    QByteArray head;
+    const auto headers = msg->headers();
+    for (const KMime::Headers::Base *header : headers) {
+        const bool contentHeader = qstrnicmp(header->type(), "Content-", 8) == 0;
+        if (!contentHeader || (inlinePGP && qstricmp(header->type(), "Content-Transfer-Encoding") != 0)) {
+            head += header->as7BitString() + '\n';
+        }
+    }
+    QByteArray body;
+    if (inlinePGP) {
+        head += "Content-Transfer-Encoding: 8bit\n";
+        body = plainText;
+    } else {
+        KMime::Content decrypted;
+        decrypted.setContent(KMime::CRLFtoLF(plainText));
+        head += decrypted.head();
+        if (!head.endsWith('\n')) {
+            head += '\n';
+        }
+        body = decrypted.body();
+    }
+    KMime::Message::Ptr decMsg(new KMime::Message);
+    decMsg->setContent(head + '\n' + body);
+    decMsg->parse();
+    return decMsg;
+}
+
+QString messageSubject(const Akonadi::Item &item)
+{
+    const auto msg = item.hasPayload<KMime::Message::Ptr>() ? item.payload<KMime::Message::Ptr>() : KMime::Message::Ptr();
+    const QString subject = (msg && msg->subject(false)) ? msg->subject(false)->asUnicodeString() : QString();
+    return subject.isEmpty() ? i18n("(No subject)") : subject;
+}
+}
+
 KMCopyDecryptedCommand::KMCopyDecryptedCommand(const Akonadi::Collection &destFolder, const Akonadi::Item::List &msgList)
     : KMCommand(nullptr, msgList)
     , mDestFolder(destFolder)
 {
-    fetchScope().fetchAllAttributes();
-    fetchScope().fetchFullPayload();
+    // The payloads are fetched chunk by chunk in fetchNextChunk()
 }
 
 KMCopyDecryptedCommand::KMCopyDecryptedCommand(const Akonadi::Collection &destFolder, const Akonadi::Item &msg)
@@ -1444,53 +1591,213 @@ KMCopyDecryptedCommand::KMCopyDecryptedCommand(const Akonadi::Collection &destFo
 KMCommand::Result KMCopyDecryptedCommand::execute()
 {
     setDeletesItself(true);
+    setEmitsCompletedItself(true);
 
-    const auto items = retrievedMsgs();
-    for (const auto &item : items) {
-        // Decrypt
-        if (!item.hasPayload<KMime::Message::Ptr>()) {
-            continue;
+    mItemsToDecrypt = retrievedMsgs();
+    if (mItemsToDecrypt.isEmpty()) {
+        setResult(OK);
+        Q_EMIT completed(this);
+        deleteLater();
+        return KMCommand::OK;
+    }
+
+    mProgressItem
+        = ProgressManager::createProgressItem(QLatin1String("copydecrypted") + ProgressManager::getUniqueID(),
+                                              i18n("Copying decrypted messages"), QString(), true, KPIM::ProgressItem::Unknown);
+    connect(mProgressItem.data(), &ProgressItem::progressItemCanceled,
+            this, &KMCopyDecryptedCommand::slotCanceled);
+
+    fetchNextChunk();
+    return KMCommand::OK;
+}
+
+void KMCopyDecryptedCommand::fetchNextChunk()
+{
+    // Only keep one chunk of payloads in memory
+    if (mFetchJob || mCanceled || !mFetchedItems.isEmpty() || mNextItem >= mItemsToDecrypt.count()) {
+        return;
+    }
+    const Akonadi::Item::List chunk = mItemsToDecrypt.mid(mNextItem, sDecryptedItemsBatchSize);
+    mNextItem += chunk.count();
+
+    auto job = new Akonadi::ItemFetchJob(chunk, this);
+    job->fetchScope().fetchFullPayload();
+    connect(job, &Akonadi::ItemFetchJob::itemsReceived, this, [this](const Akonadi::Item::List &items) {
+        if (!mCanceled) {
+            mFetchedItems += items;
         }
-        const auto msg = item.payload<KMime::Message::Ptr>();
-        bool wasEncrypted;
-        auto decMsg = MailCommon::CryptoUtils::decryptMessage(msg, wasEncrypted);
-        if (!wasEncrypted) {
-            decMsg = msg;
+    });
+    connect(job, &KJob::result, this, &KMCopyDecryptedCommand::slotFetchResult);
+    mFetchJob = job;
+}
+
+void KMCopyDecryptedCommand::slotFetchResult(KJob *job)
+{
+    mFetchJob = nullptr;
+    if (job->error()) {
+        showJobError(job);
+    }
+    decryptNextMessages();
+}
+
+void KMCopyDecryptedCommand::decryptNextMessages()
+{
+    while (!mCanceled
+           && !mFetchedItems.isEmpty()
+           && mRunningDecryptions < sMaxRunningDecryptions
+           && mPendingJobs.count() < sMaxPendingTransactions) {
+        decryptMessage(mFetchedItems.takeFirst());
+    }
+    fetchNextChunk();
+    checkFinished();
+}
+
+void KMCopyDecryptedCommand::decryptMessage(const Akonadi::Item &item)
+{
+    ++mRunningDecryptions;
+    if (!item.hasPayload<KMime::Message::Ptr>()) {
+        slotMessageDecrypted(item, KMime::Message::Ptr());
+        return;
+    }
+    const auto msg = item.payload<KMime::Message::Ptr>();
+    const EncryptedData data = encryptedData(msg);
+    if (!data.protocol) {
+        // Not encrypted, or with a protocol we don't support: copy it as is
+        slotMessageDecrypted(item, msg);
+        return;
+    }
+
+    // The job does its work in its own thread and reports back to this one
+    QGpgME::DecryptJob *job = data.protocol->decryptJob();
+    if (!job) {
+        slotMessageDecrypted(item, KMime::Message::Ptr());
+        return;
+    }
+    const bool inlinePGP = data.inlinePGP;
+    connect(job, &QGpgME::DecryptJob::result, this, [this, item, msg, inlinePGP](const GpgME::DecryptionResult &result, const QByteArray &plainText) {
+        if (result.error()) {
+            qCWarning(KMAIL_LOG) << "Unable to decrypt message:" << result.error().asString();
+            slotMessageDecrypted(item, KMime::Message::Ptr());
+        } else {
+            slotMessageDecrypted(item, assembleDecryptedMessage(msg, plainText, inlinePGP));
         }
+    });
+    const GpgME::Error error = job->start(data.cipherText);
+    if (error) {
+        qCWarning(KMAIL_LOG) << "Unable to start decrypting message:" << error.asString();
+        slotMessageDecrypted(item, KMime::Message::Ptr());
+    }
+}
 
+void KMCopyDecryptedCommand::slotMessageDecrypted(const Akonadi::Item &item, const KMime::Message::Ptr &decMsg)
+{
+    --mRunningDecryptions;
+    ++mProcessedItems;
+    if (!decMsg) {
+        mFailedMessages << messageSubject(item);
+    } else if (!mCanceled) {
         Akonadi::Item decItem;
         decItem.setMimeType(KMime::Message::mimeType());
         decItem.setPayload(decMsg);
-
-        auto job = new Akonadi::ItemCreateJob(decItem, mDestFolder, this);
-        connect(job, &Akonadi::Job::result, this, &KMCopyDecryptedCommand::slotAppendResult);
-        mPendingJobs << job;
+        mDecryptedItems << decItem;
+    }
+    if (mProgressItem) {
+        mProgressItem->setProgress(100 * mProcessedItems / mItemsToDecrypt.count());
     }
 
-    if (mPendingJobs.isEmpty()) {
-        Q_EMIT completed(this);
-        deleteLater();
+    const bool allDecrypted = (mRunningDecryptions == 0) && !mFetchJob
+                              && mFetchedItems.isEmpty() && (mNextItem >= mItemsToDecrypt.count());
+    if (mDecryptedItems.count() >= sDecryptedItemsBatchSize || allDecrypted) {
+        writeDecryptedItems();
     }
+    // Don't recurse from decryptMessage() when the message didn't need the backend
+    QTimer::singleShot(0, this, &KMCopyDecryptedCommand::decryptNextMessages);
+}
 
-    return KMCommand::OK;
+void KMCopyDecryptedCommand::writeDecryptedItems()
+{
+    if (mDecryptedItems.isEmpty()) {
+        return;
+    }
+    // Write the whole batch in one transaction, but don't let a single failure roll it back
+    auto transaction = new Akonadi::TransactionSequence(this);
+    for (const Akonadi::Item &decItem : qAsConst(mDecryptedItems)) {
+        auto job = new Akonadi::ItemCreateJob(decItem, mDestFolder, transaction);
+        transaction->setIgnoreJobFailure(job);
+        const QString subject = messageSubject(decItem);
+        connect(job, &Akonadi::Job::result, this, [this, subject](KJob *job) {
+            if (job->error()) {
+                qCWarning(KMAIL_LOG) << "Unable to store decrypted message:" << job->errorString();
+                mFailedMessages << subject;
+            }
+        });
+    }
+    connect(transaction, &Akonadi::Job::result, this, &KMCopyDecryptedCommand::slotAppendResult);
+    mPendingJobs << transaction;
+    mDecryptedItems.clear();
 }
 
 void KMCopyDecryptedCommand::slotAppendResult(KJob *job)
 {
+    if (job->error()) {
+        showJobError(job);
+    }
     mPendingJobs.removeOne(job);
-    if (mPendingJobs.isEmpty()) {
-        Q_EMIT completed(this);
-        deleteLater();
+    decryptNextMessages();
+}
+
+void KMCopyDecryptedCommand::slotCanceled()
+{
+    // Running jobs are left to finish, their results are dropped
+    mCanceled = true;
+    mFetchedItems.clear();
+    mDecryptedItems.clear();
+    if (mProgressItem) {
+        mProgressItem->setComplete();
+        mProgressItem = nullptr;
+    }
+    checkFinished();
+}
+
+void KMCopyDecryptedCommand::checkFinished()
+{
+    if (mFinished || mFetchJob || mRunningDecryptions > 0 || !mPendingJobs.isEmpty()) {
+        return;
+    }
+    if (!mCanceled && (mNextItem < mItemsToDecrypt.count() || !mFetchedItems.isEmpty() || !mDecryptedItems.isEmpty())) {
+        return;
+    }
+    mFinished = true;
+
+    if (mProgressItem) {
+        mProgressItem->setComplete();
+        mProgressItem = nullptr;
+    }
+    if (!mFailedMessages.isEmpty()) {
+        KMessageBox::errorList(parentWidget(),
+                               i18np("One message could not be decrypted and copied:",
+                                     "%1 messages could not be decrypted and copied:", mFailedMessages.count()),
+                               mFailedMessages,
+                               i18n("Copy Decrypted Messages"));
     }
+    if (mCanceled) {
+        setResult(Canceled);
+    } else {
+        setResult(mFailedMessages.isEmpty() ? OK : Failed);
+    }
+    Q_EMIT completed(this);
+    deleteLater();
 }
 
+// The items given by the message list already know their storage collection,
+// so the move starts right away without fetching them first. Only items
+// without that information are fetched, for the undo grouping.
 KMMoveCommand::KMMoveCommand(const Akonadi::Collection &destFolder, const Akonadi::Item::List &msgList, MessageList::Core::MessageItemSetReference ref)
     : KMCommand(nullptr, msgList)
     , mDestFolder(destFolder)
     , mProgressItem(nullptr)
     , mRef(ref)
 {
-    fetchScope().setAncestorRetrieval(Akonadi::ItemFetchScope::Parent);
 }
 
 KMMoveCommand::KMMoveCommand(const Akonadi::Collection &destFolder, const Akonadi::Item &msg, MessageList::Core::MessageItemSetReference ref)
@@ -1499,17 +1806,72 @@ KMMoveCommand::KMMoveCommand(const Akonadi::Collection &destFolder, const Akonad
     , mProgressItem(nullptr)
     , mRef(ref)
 {
-    fetchScope().setAncestorRetrieval(Akonadi::ItemFetchScope::Parent);
 }
 
 void KMMoveCommand::slotMoveResult(KJob *job)
 {
+    if (job != mCurrentJob) {
+        return;
+    }
+    mCurrentJob = nullptr;
+    const Akonadi::Item::List chunk = mCurrentChunk;
+    mCurrentChunk.clear();
     if (job->error()) {
         // handle errors
         showJobError(job);
         completeMove(Failed);
-    } else {
+        return;
+    }
+    // Only what was actually moved can be undone
+    if (mDestFolder.isValid()) {
+        addUndoActions(chunk);
+    }
+    if (mCanceled) {
+        completeMove(Canceled);
+    } else if (mNextItem >= mItems.count()) {
         completeMove(OK);
+    } else {
+        if (mProgressItem) {
+            mProgressItem->setProgress(100 * mNextItem / mItems.count());
+        }
+        moveNextChunk();
+    }
+}
+
+void KMMoveCommand::addUndoActions(Akonadi::Item::List items)
+{
+    const auto sourceId = [this](const Akonadi::Item &item) {
+        return item.storageCollectionId() > 0 ? item.storageCollectionId() : mParentIds.value(item.id(), -1);
+    };
+    // group by source folder for undo
+    std::sort(items.begin(), items.end(),
+              [&sourceId](const Akonadi::Item &lhs, const Akonadi::Item &rhs) {
+        return sourceId(lhs) < sourceId(rhs);
+    });
+    Akonadi::Collection parent;
+    int undoId = -1;
+    for (const Akonadi::Item &item : qAsConst(items)) {
+        const Akonadi::Collection::Id source = sourceId(item);
+        if (source <= 0) {
+            continue;
+        }
+        if (parent.id() != source) {
+            parent = Akonadi::Collection(source);
+            undoId = kmkernel->undoStack()->newUndoAction(parent, mDestFolder);
+        }
+        kmkernel->undoStack()->addMsgToAction(undoId, item);
+    }
+}
+
+void KMMoveCommand::slotParentsFetched(KJob *job)
+{
+    if (job->error()) {
+        qCWarning(KMAIL_LOG) << "Unable to fetch the source folders for undo:" << job->errorString();
+        return;
+    }
+    const Akonadi::Item::List items = static_cast<Akonadi::ItemFetchJob *>(job)->items();
+    for (const Akonadi::Item &item : items) {
+        mParentIds.insert(item.id(), item.storageCollectionId());
     }
 }
 
@@ -1520,50 +1882,59 @@ KMCommand::Result KMMoveCommand::execute()
 #endif
     setEmitsCompletedItself(true);
     setDeletesItself(true);
-    Akonadi::Item::List retrievedList = retrievedMsgs();
-    if (!retrievedList.isEmpty()) {
-        if (mDestFolder.isValid()) {
-            Akonadi::ItemMoveJob *job = new Akonadi::ItemMoveJob(retrievedList, mDestFolder, this);
-            connect(job, &KIO::Job::result, this, &KMMoveCommand::slotMoveResult);
-
-            // group by source folder for undo
-            std::sort(retrievedList.begin(), retrievedList.end(),
-                      [](const Akonadi::Item &lhs, const Akonadi::Item &rhs) {
-                return lhs.storageCollectionId() < rhs.storageCollectionId();
-            });
-            Akonadi::Collection parent;
-            int undoId = -1;
-            for (const Akonadi::Item &item : qAsConst(retrievedList)) {
-                if (item.storageCollectionId() <= 0) {
-                    continue;
-                }
-                if (parent.id() != item.storageCollectionId()) {
-                    parent = Akonadi::Collection(item.storageCollectionId());
-                    undoId = kmkernel->undoStack()->newUndoAction(parent, mDestFolder);
-                }
-                kmkernel->undoStack()->addMsgToAction(undoId, item);
-            }
-        } else {
-            Akonadi::ItemDeleteJob *job = new Akonadi::ItemDeleteJob(retrievedList, this);
-            connect(job, &KIO::Job::result, this, &KMMoveCommand::slotMoveResult);
-        }
-    } else {
+    mItems = retrievedMsgs();
+    if (mItems.isEmpty()) {
         deleteLater();
         return Failed;
     }
+
+    if (mDestFolder.isValid()) {
+        Akonadi::Item::List unknownParents;
+        for (const Akonadi::Item &item : qAsConst(mItems)) {
+            if (item.storageCollectionId() <= 0) {
+                unknownParents.append(item);
+            }
+        }
+        if (!unknownParents.isEmpty()) {
+            // Jobs of a session run in order, so this fetch still sees the
+            // source folders before the first chunk is moved
+            Akonadi::ItemFetchJob *fetch = new Akonadi::ItemFetchJob(unknownParents, this);
+            fetch->fetchScope().setAncestorRetrieval(Akonadi::ItemFetchScope::Parent);
+            fetch->fetchScope().setFetchModificationTime(false);
+            connect(fetch, &KJob::result, this, &KMMoveCommand::slotParentsFetched);
+        }
+    }
+
     // TODO set SSL state according to source and destfolder connection?
     Q_ASSERT(!mProgressItem);
     mProgressItem
         = ProgressManager::createProgressItem(QLatin1String("move") + ProgressManager::getUniqueID(),
                                               mDestFolder.isValid() ? i18n("Moving messages") : i18n("Deleting messages"), QString(), true, KPIM::ProgressItem::Unknown);
-    mProgressItem->setUsesBusyIndicator(true);
+    mProgressItem->setUsesBusyIndicator(mItems.count() <= sMoveChunkSize);
     connect(mProgressItem, &ProgressItem::progressItemCanceled,
             this, &KMMoveCommand::slotMoveCanceled);
+
+    moveNextChunk();
     return OK;
 }
 
+void KMMoveCommand::moveNextChunk()
+{
+    // One chunk at a time: stopping after a failure or a cancellation then
+    // never needs to kill a job, which would reset the whole Akonadi session
+    mCurrentChunk = mItems.mid(mNextItem, sMoveChunkSize);
+    mNextItem += mCurrentChunk.count();
+    if (mDestFolder.isValid()) {
+        mCurrentJob = new Akonadi::ItemMoveJob(mCurrentChunk, mDestFolder, this);
+    } else {
+        mCurrentJob = new Akonadi::ItemDeleteJob(mCurrentChunk, this);
+    }
+    connect(mCurrentJob, &KJob::result, this, &KMMoveCommand::slotMoveResult);
+}
+
 void KMMoveCommand::completeMove(Result result)
 {
+    mCurrentJob = nullptr;
     if (mProgressItem) {
         mProgressItem->setComplete();
         mProgressItem = nullptr;
@@ -1576,7 +1947,11 @@ void KMMoveCommand::completeMove(Result result)
 
 void KMMoveCommand::slotMoveCanceled()
 {
-    completeMove(Canceled);
+    // The running chunk is finished, so that its undo information is kept
+    mCanceled = true;
+    if (!mCurrentJob) {
+        completeMove(Canceled);
+    }
 }
 
 KMTrashMsgCommand::KMTrashMsgCommand(const Akonadi::Collection &srcFolder, const Akonadi::Item::List &msgList, MessageList::Core::MessageItemSetReference ref)
@@ -1651,31 +2026,19 @@ KMCommand::Result KMTrashMsgCommand::execute()
     for (auto trashIt = mTrashFolders.begin(), end = mTrashFolders.end(); trashIt != end; ++trashIt) {
         const auto trash = trashIt.key();
         if (trash.isValid()) {
-            Akonadi::ItemMoveJob *job = new Akonadi::ItemMoveJob(*trashIt, trash, this);
-            connect(job, &KIO::Job::result, this, &KMTrashMsgCommand::slotMoveResult);
-            mPendingMoves.push_back(job);
-
-            // group by source folder for undo
-            std::sort(trashIt->begin(), trashIt->end(),
-                      [](const Akonadi::Item &lhs, const Akonadi::Item &rhs) {
-                return lhs.storageCollectionId() < rhs.storageCollectionId();
-            });
-            Akonadi::Collection parent;
-            int undoId = -1;
-            for (const Akonadi::Item &item : qAsConst(*trashIt)) {
-                if (item.storageCollectionId() <= 0) {
-                    continue;
-                }
-                if (parent.id() != item.storageCollectionId()) {
-                    parent = Akonadi::Collection(item.storageCollectionId());
-                    undoId = kmkernel->undoStack()->newUndoAction(parent, trash);
-                }
-                kmkernel->undoStack()->addMsgToAction(undoId, item);
+            for (int i = 0, total = trashIt->count(); i < total; i += sMoveChunkSize) {
+                const Akonadi::Item::List chunk = trashIt->mid(i, sMoveChunkSize);
+                Akonadi::ItemMoveJob *job = new Akonadi::ItemMoveJob(chunk, trash, this);
+                connect(job, &KIO::Job::result, this, &KMTrashMsgCommand::slotMoveResult);
+                mPendingMoves.push_back(job);
+                mMoveChunks.insert(job, {trash, chunk});
             }
         } else {
-            Akonadi::ItemDeleteJob *job = new Akonadi::ItemDeleteJob(*trashIt, this);
-            connect(job, &KIO::Job::result, this, &KMTrashMsgCommand::slotDeleteResult);
-            mPendingDeletes.push_back(job);
+            for (int i = 0, total = trashIt->count(); i < total; i += sMoveChunkSize) {
+                Akonadi::ItemDeleteJob *job = new Akonadi::ItemDeleteJob(trashIt->mid(i, sMoveChunkSize), this);
+                connect(job, &KIO::Job::result, this, &KMTrashMsgCommand::slotDeleteResult);
+                mPendingDeletes.push_back(job);
+            }
         }
     }
 
@@ -1706,14 +2069,17 @@ KMCommand::Result KMTrashMsgCommand::execute()
 
 void KMTrashMsgCommand::slotMoveResult(KJob *job)
 {
+    const MoveChunk chunk = mMoveChunks.take(job);
     mPendingMoves.removeOne(job);
     if (job->error()) {
         // handle errors
         showJobError(job);
-        completeMove(Failed);
-    } else if (mPendingMoves.isEmpty() && mPendingDeletes.isEmpty()) {
-        completeMove(OK);
+        mFailed = true;
+    } else {
+        // Only what was actually moved can be undone
+        addUndoActions(chunk.items, chunk.trash);
     }
+    checkFinished();
 }
 
 void KMTrashMsgCommand::slotDeleteResult(KJob *job)
@@ -1721,28 +2087,58 @@ void KMTrashMsgCommand::slotDeleteResult(KJob *job)
     mPendingDeletes.removeOne(job);
     if (job->error()) {
         showJobError(job);
-        completeMove(Failed);
-    } else if (mPendingDeletes.isEmpty() && mPendingMoves.isEmpty()) {
-        completeMove(OK);
+        mFailed = true;
+    }
+    checkFinished();
+}
+
+void KMTrashMsgCommand::addUndoActions(Akonadi::Item::List items, const Akonadi::Collection &trash)
+{
+    // group by source folder for undo
+    std::sort(items.begin(), items.end(),
+              [](const Akonadi::Item &lhs, const Akonadi::Item &rhs) {
+        return lhs.storageCollectionId() < rhs.storageCollectionId();
+    });
+    Akonadi::Collection parent;
+    int undoId = -1;
+    for (const Akonadi::Item &item : qAsConst(items)) {
+        if (item.storageCollectionId() <= 0) {
+            continue;
+        }
+        if (parent.id() != item.storageCollectionId()) {
+            parent = Akonadi::Collection(item.storageCollectionId());
+            undoId = kmkernel->undoStack()->newUndoAction(parent, trash);
+        }
+        kmkernel->undoStack()->addMsgToAction(undoId, item);
     }
 }
 
 void KMTrashMsgCommand::slotMoveCanceled()
 {
-    completeMove(Canceled);
+    // Killing the running jobs would reset the whole Akonadi session, let
+    // them end so that the undo information matches what was moved
+    mCanceled = true;
+    if (mDeleteProgress) {
+        mDeleteProgress->setComplete();
+        mDeleteProgress = nullptr;
+    }
+    if (mMoveProgress) {
+        mMoveProgress->setComplete();
+        mMoveProgress = nullptr;
+    }
+    checkFinished();
 }
 
-void KMTrashMsgCommand::completeMove(KMCommand::Result result)
+void KMTrashMsgCommand::checkFinished()
 {
-    if (result == Failed) {
-        for (auto job : qAsConst(mPendingMoves)) {
-            job->kill();
-        }
-        for (auto job : qAsConst(mPendingDeletes)) {
-            job->kill();
-        }
+    if (!mPendingMoves.isEmpty() || !mPendingDeletes.isEmpty()) {
+        return;
     }
+    completeMove(mFailed ? Failed : mCanceled ? Canceled : OK);
+}
 
+void KMTrashMsgCommand::completeMove(KMCommand::Result result)
+{
     if (mDeleteProgress) {
         mDeleteProgress->setComplete();
         mDeleteProgress = nullptr;
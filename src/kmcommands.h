@@ -11,6 +11,7 @@
 #include <kio/job.h>
 #include <kmime/kmime_message.h>
 
+#include <QHash>
 #include <QPointer>
 #include <QList>
 #include <AkonadiCore/item.h>
@@ -30,6 +31,7 @@ using Akonadi::MessageStatus;
 class QProgressDialog;
 class KMMainWidget;
 class KMReaderMainWin;
+class KMReaderWin;
 
 template<typename T> class QSharedPointer;
 
@@ -397,8 +399,13 @@ class KMPrintCommand : public KMCommand
 
 public:
     KMPrintCommand(QWidget *parent, const KMPrintCommandInfo &commandInfo);
+    /** Prints all messages of @p msgList in one go, using the settings of @p commandInfo. */
+    KMPrintCommand(QWidget *parent, const Akonadi::Item::List &msgList, const KMPrintCommandInfo &commandInfo);
+
+    static KMReaderWin *createPrinterWin(const KMPrintCommandInfo &commandInfo);
 private:
     Result execute() override;
+    void initOverrideFont();
 
     KMPrintCommandInfo mPrintCommandInfo;
 };
@@ -500,8 +507,11 @@ protected Q_SLOTS:
     void slotCopyResult(KJob *job);
 private:
     Result execute() override;
+    void copyNextChunk();
 
     Akonadi::Collection mDestFolder;
+    Akonadi::Item::List mItems;
+    int mNextItem = 0;
 };
 
 class KMCopyDecryptedCommand : public KMCommand
@@ -513,12 +523,31 @@ public:
 
 protected Q_SLOTS:
     void slotAppendResult(KJob *job);
+    void slotCanceled();
 
 private:
     Result execute() override;
+    void fetchNextChunk();
+    void slotFetchResult(KJob *job);
+    void decryptNextMessages();
+    void decryptMessage(const Akonadi::Item &item);
+    void slotMessageDecrypted(const Akonadi::Item &item, const KMime::Message::Ptr &decMsg);
+    void writeDecryptedItems();
+    void checkFinished();
 
     Akonadi::Collection mDestFolder;
+    Akonadi::Item::List mItemsToDecrypt;
+    Akonadi::Item::List mFetchedItems;
+    Akonadi::Item::List mDecryptedItems;
+    QStringList mFailedMessages;
     QList<KJob *> mPendingJobs;
+    KJob *mFetchJob = nullptr;
+    QPointer<KPIM::ProgressItem> mProgressItem;
+    int mNextItem = 0;
+    int mRunningDecryptions = 0;
+    int mProcessedItems = 0;
+    bool mCanceled = false;
+    bool mFinished = false;
 };
 
 class KMMoveCommand : public KMCommand
@@ -552,11 +581,20 @@ Q_SIGNALS:
 
 private:
     Result execute() override;
+    void moveNextChunk();
     void completeMove(Result result);
+    void addUndoActions(Akonadi::Item::List items);
+    void slotParentsFetched(KJob *job);
 
     Akonadi::Collection mDestFolder;
     KPIM::ProgressItem *mProgressItem = nullptr;
     MessageList::Core::MessageItemSetReference mRef;
+    Akonadi::Item::List mItems;
+    Akonadi::Item::List mCurrentChunk;
+    QHash<Akonadi::Item::Id, Akonadi::Collection::Id> mParentIds;
+    KJob *mCurrentJob = nullptr;
+    int mNextItem = 0;
+    bool mCanceled = false;
 };
 
 class KMTrashMsgCommand final : public KMCommand
@@ -590,7 +628,14 @@ Q_SIGNALS:
     void moveDone(KMTrashMsgCommand *);
 
 private:
+    struct MoveChunk {
+        Akonadi::Collection trash;
+        Akonadi::Item::List items;
+    };
+
     Result execute() override;
+    void addUndoActions(Akonadi::Item::List items, const Akonadi::Collection &trash);
+    void checkFinished();
     void completeMove(Result result);
 
     static Akonadi::Collection findTrashFolder(const Akonadi::Collection &srcFolder);
@@ -601,6 +646,9 @@ private:
     MessageList::Core::MessageItemSetReference mRef;
     QList<KJob *> mPendingMoves;
     QList<KJob *> mPendingDeletes;
+    QHash<KJob *, MoveChunk> mMoveChunks;
+    bool mFailed = false;
+    bool mCanceled = false;
 };
 
 class KMResendMessageCommand : public KMCommand
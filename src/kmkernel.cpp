@@ -8,12 +8,15 @@
 #include "job/newmessagejob.h"
 #include "job/opencomposerhiddenjob.h"
 #include "job/fillcomposerjob.h"
+#include "job/checkfolderfromresourcesjob.h"
 #include <AkonadiSearch/PIM/indexeditems.h>
 #include <LibkdepimAkonadi/ProgressManagerAkonadi>
 using KPIM::BroadcastStatus;
 #include "kmstartup.h"
 #include "kmmainwin.h"
 #include "editor/composer.h"
+#include "editor/composerautosave.h"
+#include "editor/potentialphishingemail/potentialphishingemailjob.h"
 #include "kmreadermainwin.h"
 #include "undostack.h"
 #include "kmmainwidget.h"
@@ -24,6 +27,8 @@ using KPIM::RecentAddresses;
 #include "configuredialog/configuredialog.h"
 #include "kmcommands.h"
 #include "unityservicemanager.h"
+#include "folderexpiryscheduler.h"
+#include "startuptrace.h"
 #include <MessageCore/StringUtil>
 #include "mailcommon/mailutil.h"
 #include "pop3settings.h"
@@ -225,6 +230,7 @@ KMKernel::KMKernel(QObject *parent)
     mIndexedItems = new Akonadi::Search::PIM::IndexedItems(this);
     mCheckIndexingManager = new CheckIndexingManager(mIndexedItems, this);
     mUnityServiceManager = new KMail::UnityServiceManager(this);
+    mFolderExpiryScheduler = new KMail::FolderExpiryScheduler(this);
 }
 
 KMKernel::~KMKernel()
@@ -233,6 +239,10 @@ KMKernel::~KMKernel()
     mMailService = nullptr;
 
     stopAgentInstance();
+    // The scheduler saves its deadlines through KMKernel::config(), which is
+    // gone once the QObject children get deleted
+    delete mFolderExpiryScheduler;
+    mFolderExpiryScheduler = nullptr;
     saveConfig();
 
     delete mAutoCorrection;
@@ -986,7 +996,8 @@ void KMKernel::recoverDeadLetters()
         QFile autoSaveFile(file.absoluteFilePath());
         if (autoSaveFile.open(QIODevice::ReadOnly)) {
             const KMime::Message::Ptr autoSaveMessage(new KMime::Message());
-            const QByteArray msgData = autoSaveFile.readAll();
+            int missingParts = 0;
+            const QByteArray msgData = ComposerAutoSave::restore(file.absoluteFilePath(), autoSaveFile.readAll(), &missingParts);
             autoSaveMessage->setContent(msgData);
             autoSaveMessage->parse();
 
@@ -996,6 +1007,13 @@ void KMKernel::recoverDeadLetters()
             autoSaveWin->setAutoSaveFileName(filename);
             autoSaveWin->show();
             autoSaveFile.close();
+            if (missingParts > 0) {
+                KMessageBox::sorry(autoSaveWin,
+                                   i18np("One attachment of the recovered message \"%2\" could not be restored and has to be attached again.",
+                                         "%1 attachments of the recovered message \"%2\" could not be restored and have to be attached again.",
+                                         missingParts, autoSaveMessage->subject()->asUnicodeString()),
+                                   i18n("Recovering Autosave File"));
+            }
         } else {
             KMessageBox::sorry(nullptr, i18n("Failed to open autosave file at %1.\nReason: %2",
                                              file.absoluteFilePath(), autoSaveFile.errorString()),
@@ -1027,6 +1045,7 @@ static void kmCrashHandler(int sigId)
 
 void KMKernel::init()
 {
+    KMail::StartupTraceScope trace("KMKernel::init");
     the_shuttingDown = false;
 
     the_firstStart = KMailSettings::self()->firstStart();
@@ -1050,6 +1069,7 @@ void KMKernel::init()
 
     qCDebug(KMAIL_LOG) << "KMail init with akonadi server state:" << int(Akonadi::ServerManager::state());
     if (Akonadi::ServerManager::state() == Akonadi::ServerManager::Running) {
+        KMail::StartupTraceScope initFoldersTrace("MailCommon::Kernel::initFolders");
         CommonKernel->initFolders();
     }
 
@@ -1248,6 +1268,7 @@ void KMKernel::slotShowConfigurationDialog()
 void KMKernel::slotConfigChanged()
 {
     CodecManager::self()->updatePreferredCharsets();
+    PotentialPhishingEmailJob::invalidateEmailWhiteList();
     Q_EMIT configChanged();
 }
 
@@ -1396,7 +1417,7 @@ void KMKernel::slotRunBackgroundTasks() // called regularly by timer
     // Hidden KConfig keys. Not meant to be used, but a nice fallback in case
     // a stable kmail release goes out with a nasty bug in CompactionJob...
     if (KMailSettings::self()->autoExpiring()) {
-        mFolderCollectionMonitor->expireAllFolders(false /*scheduled, not immediate*/, entityTreeModel());
+        mFolderExpiryScheduler->expireFolders(allFolders(), false /*only the folders which are due*/);
     }
     if (KMailSettings::self()->checkCollectionsIndexing()) {
         mCheckIndexingManager->start(entityTreeModel());
@@ -1444,7 +1465,12 @@ Akonadi::Collection::List KMKernel::subfolders(const Akonadi::Collection &col) c
 
 void KMKernel::expireAllFoldersNow() // called by the GUI
 {
-    mFolderCollectionMonitor->expireAllFolders(true /*immediate*/, entityTreeModel());
+    mFolderExpiryScheduler->expireFolders(allFolders(), true /*immediate*/);
+}
+
+void KMKernel::expireFolderNow(const Akonadi::Collection &collection) // called by the GUI
+{
+    mFolderExpiryScheduler->expireFolders(Akonadi::Collection::List() << collection, true /*immediate*/);
 }
 
 bool KMKernel::canQueryClose()
@@ -1571,6 +1597,8 @@ void KMKernel::instanceStatusChanged(const Akonadi::AgentInstance &instance)
         progress->setProperty("AgentIdentifier", instance.identifier());
         return;
     }
+    //Settings may have been changed by the resource configuration dialog
+    mResourceFolderSettingCache.remove(instance.identifier());
     if (MailCommon::Util::agentInstances(true).contains(instance)) {
         if (instance.status() == Akonadi::AgentInstance::Running) {
             if (mResourcesBeingChecked.isEmpty()) {
@@ -1747,43 +1775,13 @@ void KMKernel::createFilter(const QByteArray &field, const QString &value)
 
 void KMKernel::checkFolderFromResources(const Akonadi::Collection::List &collectionList)
 {
-    const Akonadi::AgentInstance::List lst = MailCommon::Util::agentInstances();
-    for (const Akonadi::AgentInstance &type : lst) {
-        if (type.status() == Akonadi::AgentInstance::Broken) {
-            continue;
-        }
-        const QString typeIdentifier(type.identifier());
-        if (PimCommon::Util::isImapResource(typeIdentifier)) {
-            OrgKdeAkonadiImapSettingsInterface *iface = PimCommon::Util::createImapSettingsInterface(typeIdentifier);
-            if (iface && iface->isValid()) {
-                const Akonadi::Collection::Id imapTrashId = iface->trashCollection();
-                for (const Akonadi::Collection &collection : collectionList) {
-                    const Akonadi::Collection::Id collectionId = collection.id();
-                    if (imapTrashId == collectionId) {
-                        //Use default trash
-                        iface->setTrashCollection(CommonKernel->trashCollectionFolder().id());
-                        iface->save();
-                        break;
-                    }
-                }
-            }
-            delete iface;
-        } else if (typeIdentifier.contains(POP3_RESOURCE_IDENTIFIER)) {
-            OrgKdeAkonadiPOP3SettingsInterface *iface = MailCommon::Util::createPop3SettingsInterface(typeIdentifier);
-            if (iface->isValid()) {
-                for (const Akonadi::Collection &collection : qAsConst(collectionList)) {
-                    const Akonadi::Collection::Id collectionId = collection.id();
-                    if (iface->targetCollection() == collectionId) {
-                        //Use default inbox
-                        iface->setTargetCollection(CommonKernel->inboxCollectionFolder().id());
-                        iface->save();
-                        break;
-                    }
-                }
-            }
-            delete iface;
-        }
-    }
+    CheckFolderFromResourcesJob *job = new CheckFolderFromResourcesJob(this);
+    job->setCollections(collectionList);
+    job->setCachedSettings(mResourceFolderSettingCache);
+    connect(job, &CheckFolderFromResourcesJob::resourceSettingRead, this, [this](const QString &identifier, Akonadi::Collection::Id collectionId) {
+        mResourceFolderSettingCache.insert(identifier, collectionId);
+    });
+    job->start();
 }
 
 const QAbstractItemModel *KMKernel::treeviewModelSelection()
@@ -1829,6 +1827,7 @@ void KMKernel::slotInstanceRemoved(const Akonadi::AgentInstance &instance)
     if (mResourceCryptoSettingCache.contains(identifier)) {
         mResourceCryptoSettingCache.remove(identifier);
     }
+    mResourceFolderSettingCache.remove(identifier);
     mFolderArchiveManager->slotInstanceRemoved(instance);
 
     if (MailCommon::Util::isMailAgent(instance)) {
@@ -56,6 +56,7 @@ namespace KMail {
 class MailServiceImpl;
 class UndoStack;
 class UnityServiceManager;
+class FolderExpiryScheduler;
 }
 namespace MessageComposer {
 class AkonadiSender;
@@ -338,6 +339,8 @@ public:
 
     /** Expire all folders, used for the gui action */
     void expireAllFoldersNow();
+    /** Expire one folder, used for the gui action */
+    void expireFolderNow(const Akonadi::Collection &collection);
 
     bool firstStart() const;
     bool shuttingDown() const;
@@ -504,6 +507,7 @@ private:
 
     KMail::UnityServiceManager *mUnityServiceManager = nullptr;
     QHash<QString, KPIM::ProgressItem::CryptoStatus> mResourceCryptoSettingCache;
+    QHash<QString, Akonadi::Collection::Id> mResourceFolderSettingCache;
     MailCommon::FolderCollectionMonitor *mFolderCollectionMonitor = nullptr;
     Akonadi::EntityTreeModel *mEntityTreeModel = nullptr;
     Akonadi::EntityMimeTypeFilterModel *mCollectionModel = nullptr;
@@ -515,6 +519,7 @@ private:
     PimCommon::AutoCorrection *mAutoCorrection = nullptr;
     FolderArchiveManager *mFolderArchiveManager = nullptr;
     CheckIndexingManager *mCheckIndexingManager = nullptr;
+    KMail::FolderExpiryScheduler *mFolderExpiryScheduler = nullptr;
     Akonadi::Search::PIM::IndexedItems *mIndexedItems = nullptr;
     MailCommon::MailCommonSettings *mMailCommonSettings = nullptr;
     bool mDebug = false;
@@ -157,6 +157,8 @@
 #include <kstandardshortcut.h>
 #include <kcharsets.h>
 #include "kmail_debug.h"
+#include "templatesfolderindex.h"
+#include "startuptrace.h"
 #include <ktip.h>
 
 #include <kstandardaction.h>
@@ -184,9 +186,10 @@
 // System includes
 #include <AkonadiWidgets/standardactionmanager.h>
 #include <QStandardPaths>
-#include <QDBusInterface>
+#include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
 #include <QDBusConnection>
-#include <QDBusReply>
 
 #include "PimCommonAkonadi/ManageServerSideSubscriptionJob"
 #include <job/removeduplicatemailjob.h>
@@ -208,6 +211,7 @@ KMMainWidget::KMMainWidget(QWidget *parent, KXMLGUIClient *aGUIClient, KActionCo
     : QWidget(parent)
     , mManageShowCollectionProperties(new ManageShowCollectionProperties(this, this))
 {
+    KMail::StartupTraceScope trace("KMMainWidget::KMMainWidget");
     mLaunchExternalComponent = new KMLaunchExternalComponent(this, this);
     // must be the first line of the constructor:
     mStartupDone = false;
@@ -232,7 +236,10 @@ KMMainWidget::KMMainWidget(QWidget *parent, KXMLGUIClient *aGUIClient, KActionCo
     mToolbarActionSeparator->setSeparator(true);
 
     KMailPluginInterface::self()->setActionCollection(mActionCollection);
-    KMailPluginInterface::self()->initializePlugins();
+    {
+        KMail::StartupTraceScope trace("KMailPluginInterface::initializePlugins");
+        KMailPluginInterface::self()->initializePlugins();
+    }
     KMailPluginInterface::self()->setMainWidget(this);
 
     theMainWidgetList->append(this);
@@ -267,8 +274,6 @@ KMMainWidget::KMMainWidget(QWidget *parent, KXMLGUIClient *aGUIClient, KActionCo
     connect(mTagActionManager, &KMail::TagActionManager::tagMoreActionClicked,
             this, &KMMainWidget::slotSelectMoreMessageTagList);
 
-    kmkernel->toggleSystemTray();
-
     {
         // make sure the pages are registered only once, since there can be multiple instances of KMMainWidget
         static bool pagesRegistered = false;
@@ -330,7 +335,47 @@ KMMainWidget::KMMainWidget(QWidget *parent, KXMLGUIClient *aGUIClient, KActionCo
     mCheckMailTimer.setSingleShot(true);
     connect(&mCheckMailTimer, &QTimer::timeout, this, &KMMainWidget::slotUpdateActionsAfterMailChecking);
 
-    setupUnifiedMailboxChecker();
+    // Everything which is not needed to show the message list is set up
+    // once the message list was painted for the first time. The timer is
+    // a fallback for when the message list is not visible at startup.
+    mMessagePane->installEventFilter(this);
+    QTimer::singleShot(3000, this, &KMMainWidget::slotDelayedInitialization);
+}
+
+bool KMMainWidget::eventFilter(QObject *obj, QEvent *event)
+{
+    if (obj == mMessagePane && event->type() == QEvent::Paint) {
+        mMessagePane->removeEventFilter(this);
+        KMail::StartupTrace::addInstant("Message list painted");
+        QTimer::singleShot(0, this, &KMMainWidget::slotDelayedInitialization);
+    }
+    return QWidget::eventFilter(obj, event);
+}
+
+void KMMainWidget::slotDelayedInitialization()
+{
+    if (mDelayedInitializationDone || mDestructed) {
+        return;
+    }
+    mDelayedInitializationDone = true;
+    if (mMessagePane) {
+        mMessagePane->removeEventFilter(this);
+    }
+    {
+        KMail::StartupTraceScope trace("KMMainWidget::slotDelayedInitialization");
+        checkAkonadiServerManagerState();
+        {
+            KMail::StartupTraceScope folderShortcutTrace("FolderShortcutActionManager::createActions");
+            mFolderShortcutActionManager->createActions();
+        }
+        initializePluginActions();
+        {
+            KMail::StartupTraceScope systemTrayTrace("KMKernel::toggleSystemTray");
+            kmkernel->toggleSystemTray();
+        }
+        setupUnifiedMailboxChecker();
+    }
+    KMail::StartupTrace::finish();
 }
 
 void KMMainWidget::restoreCollectionFolderViewConfig()
@@ -550,6 +595,7 @@ void KMMainWidget::slotShowSelectedFolderInPane()
         QModelIndex idx = Akonadi::EntityTreeModel::modelIndexForCollection(KMKernel::self()->entityTreeModel(), mCurrentCollection);
         mMessagePane->setCurrentFolder(mCurrentCollection, idx, false, mPreSelectionMode);
     }
+    mSelectionStatsDirty = true;
     updateMessageActions();
     updateFolderMenu();
 }
@@ -557,6 +603,7 @@ void KMMainWidget::slotShowSelectedFolderInPane()
 //-----------------------------------------------------------------------------
 void KMMainWidget::readPreConfig()
 {
+    KMail::StartupTraceScope trace("KMMainWidget::readPreConfig");
     mLongFolderList = KMailSettings::self()->folderList() == KMailSettings::EnumFolderList::longlist;
     mReaderWindowActive = KMailSettings::self()->readerWindowMode() != KMailSettings::EnumReaderWindowMode::hide;
     mReaderWindowBelow = KMailSettings::self()->readerWindowMode() == KMailSettings::EnumReaderWindowMode::below;
@@ -818,6 +865,7 @@ void KMMainWidget::refreshFavoriteFoldersViewProperties()
 //-----------------------------------------------------------------------------
 void KMMainWidget::readConfig()
 {
+    KMail::StartupTraceScope trace("KMMainWidget::readConfig");
     const bool oldLongFolderList = mLongFolderList;
     const bool oldReaderWindowActive = mReaderWindowActive;
     const bool oldReaderWindowBelow = mReaderWindowBelow;
@@ -989,6 +1037,7 @@ void KMMainWidget::deleteWidgets()
 //-----------------------------------------------------------------------------
 void KMMainWidget::createWidgets()
 {
+    KMail::StartupTraceScope trace("KMMainWidget::createWidgets");
     // Note that all widgets we create in this function have the parent 'this'.
     // They will be properly reparented in layoutSplitters()
 
@@ -1348,33 +1397,39 @@ void KMMainWidget::slotShowNewFromTemplate()
         return;
     }
 
-    mTemplateMenu->menu()->clear();
-
-    Akonadi::ItemFetchJob *job = new Akonadi::ItemFetchJob(mTemplateFolder);
-    job->fetchScope().setAncestorRetrieval(ItemFetchScope::Parent);
-    job->fetchScope().fetchFullPayload();
-    connect(job, &Akonadi::ItemFetchJob::result, this, &KMMainWidget::slotDelayedShowNewFromTemplate);
+    if (!mTemplatesFolderIndex) {
+        mTemplatesFolderIndex = new TemplatesFolderIndex(this);
+        connect(mTemplatesFolderIndex, &TemplatesFolderIndex::loaded, this, &KMMainWidget::slotDelayedShowNewFromTemplate);
+        connect(mTemplatesFolderIndex, &TemplatesFolderIndex::changed, this, &KMMainWidget::slotDelayedShowNewFromTemplate);
+    }
+    mTemplatesFolderIndex->setCollection(mTemplateFolder);
+    if (mTemplatesFolderIndex->isLoaded()) {
+        slotDelayedShowNewFromTemplate();
+    } else {
+        mTemplateMenu->menu()->clear();
+        mTemplatesFolderIndex->load();
+    }
 }
 
-void KMMainWidget::slotDelayedShowNewFromTemplate(KJob *job)
+void KMMainWidget::slotDelayedShowNewFromTemplate()
 {
-    Akonadi::ItemFetchJob *fetchJob = qobject_cast<Akonadi::ItemFetchJob *>(job);
-
-    const Akonadi::Item::List items = fetchJob->items();
-    const int numberOfItems = items.count();
-    for (int idx = 0; idx < numberOfItems; ++idx) {
-        KMime::Message::Ptr msg = MessageComposer::Util::message(items.at(idx));
-        if (msg) {
-            QString subj = msg->subject()->asUnicodeString();
-            if (subj.isEmpty()) {
-                subj = i18n("No Subject");
-            }
+    mTemplateMenu->menu()->clear();
 
-            QAction *templateAction = mTemplateMenu->menu()->addAction(KStringHandler::rsqueeze(subj.replace(QLatin1Char('&'), QStringLiteral("&&"))));
-            QVariant var;
-            var.setValue(items.at(idx));
-            templateAction->setData(var);
+    // Only the subjects are known here, the template itself is fetched
+    // by KMUseTemplateCommand once it is chosen.
+    const QMap<Akonadi::Item::Id, QString> subjects = mTemplatesFolderIndex->subjects();
+    for (auto it = subjects.cbegin(), end = subjects.cend(); it != end; ++it) {
+        QString subj = it.value();
+        if (subj.isEmpty()) {
+            subj = i18n("No Subject");
         }
+
+        QAction *templateAction = mTemplateMenu->menu()->addAction(KStringHandler::rsqueeze(subj.replace(QLatin1Char('&'), QStringLiteral("&&"))));
+        Akonadi::Item item(it.key());
+        item.setParentCollection(mTemplatesFolderIndex->collection());
+        QVariant var;
+        var.setValue(item);
+        templateAction->setData(var);
     }
 
     // If there are no templates available, add a menu entry which informs
@@ -1454,7 +1509,7 @@ void KMMainWidget::slotExpireFolder()
         }
     }
 
-    MailCommon::Util::expireOldMessages(mCurrentCollection, true /*immediate*/);
+    kmkernel->expireFolderNow(mCurrentCollection);
     if (mustDeleteExpirationAttribute) {
         delete attr;
     }
@@ -2832,6 +2887,7 @@ void KMMainWidget::setZoomChanged(qreal zoomFactor)
 
 void KMMainWidget::setupActions()
 {
+    KMail::StartupTraceScope trace("KMMainWidget::setupActions");
     KMailPluginInterface::self()->setParentWidget(this);
     KMailPluginInterface::self()->createPluginInterface();
     mMsgActions = new KMail::MessageActions(actionCollection(), this);
@@ -3684,6 +3740,7 @@ void KMMainWidget::updateMessageMenu()
 
 void KMMainWidget::startUpdateMessageActionsTimer()
 {
+    mSelectionStatsDirty = true;
     // FIXME: This delay effectively CAN make the actions to be in an incoherent state
     //        Maybe we should mark actions as "dirty" here and check it in every action handler...
     updateMessageActions(true);
@@ -3692,15 +3749,32 @@ void KMMainWidget::startUpdateMessageActionsTimer()
     menutimer->start(500);
 }
 
+const KMMainWidget::SelectionStats &KMMainWidget::selectionStats()
+{
+    // Walking the selection of the pane is expensive for large selections
+    // (e.g. after "select all"), so only do it once per selection change.
+    // Commands still ask the pane for the selected items when they run.
+    if (mSelectionStatsDirty) {
+        Akonadi::Item::List selectedItems;
+        Akonadi::Item::List selectedVisibleItems;
+        bool allSelectedBelongToSameThread = false;
+        mSelectionStats = SelectionStats();
+        if (mMessagePane->getSelectionStats(selectedItems, selectedVisibleItems, &allSelectedBelongToSameThread)) {
+            mSelectionStats.hasSelection = true;
+            mSelectionStats.count = selectedItems.count();
+            mSelectionStats.visibleCount = selectedVisibleItems.count();
+            mSelectionStats.allSelectedBelongToSameThread = allSelectedBelongToSameThread;
+        }
+        mSelectionStatsDirty = false;
+    }
+    return mSelectionStats;
+}
+
 void KMMainWidget::updateMessageActions(bool fast)
 {
-    Akonadi::Item::List selectedItems;
-    Akonadi::Item::List selectedVisibleItems;
-    bool allSelectedBelongToSameThread = false;
     if (mCurrentFolderSettings && mCurrentFolderSettings->isValid()
-        && mMessagePane->getSelectionStats(selectedItems, selectedVisibleItems, &allSelectedBelongToSameThread)
-        ) {
-        mMsgActions->setCurrentMessage(mMessagePane->currentItem(), selectedVisibleItems);
+        && selectionStats().hasSelection) {
+        mMsgActions->setCurrentMessage(mMessagePane->currentItem(), mSelectionStats.visibleCount);
     } else {
         mMsgActions->setCurrentMessage(Akonadi::Item());
     }
@@ -3713,15 +3787,15 @@ void KMMainWidget::updateMessageActions(bool fast)
 void KMMainWidget::updateMessageActionsDelayed()
 {
     int count;
-    Akonadi::Item::List selectedItems;
-    Akonadi::Item::List selectedVisibleItems;
+    int visibleCount = 0;
     bool allSelectedBelongToSameThread = false;
     Akonadi::Item currentMessage;
     bool currentFolderSettingsIsValid = mCurrentFolderSettings && mCurrentFolderSettings->isValid();
     if (currentFolderSettingsIsValid
-        && mMessagePane->getSelectionStats(selectedItems, selectedVisibleItems, &allSelectedBelongToSameThread)
-        ) {
-        count = selectedItems.count();
+        && selectionStats().hasSelection) {
+        count = mSelectionStats.count;
+        visibleCount = mSelectionStats.visibleCount;
+        allSelectedBelongToSameThread = mSelectionStats.allSelectedBelongToSameThread;
 
         currentMessage = mMessagePane->currentItem();
     } else {
@@ -3764,7 +3838,7 @@ void KMMainWidget::updateMessageActionsDelayed()
     // can we apply strictly single message actions ? (this is false if the whole selection contains more than one message)
     const bool single_actions = count == 1;
     // can we apply loosely single message actions ? (this is false if the VISIBLE selection contains more than one message)
-    const bool singleVisibleMessageSelected = selectedVisibleItems.count() == 1;
+    const bool singleVisibleMessageSelected = visibleCount == 1;
     // can we apply "mass" actions to the selection ? (this is actually always true if the selection is non-empty)
     const bool mass_actions = count >= 1;
     // does the selection identify a single thread ?
@@ -3829,11 +3903,12 @@ void KMMainWidget::updateMessageActionsDelayed()
         menuCustom->replyAllActionMenu()->setEnabled(single_actions);
     }
 
-    // "Print" will act on the current message: it will ignore any hidden selection
-    mMsgActions->printAction()->setEnabled(singleVisibleMessageSelected && mMsgView);
-    // "Print preview" will act on the current message: it will ignore any hidden selection
+    // "Print" will act on the visible selection: it will ignore any hidden selection
+    const bool canPrint = (singleVisibleMessageSelected || visibleCount > 1) && mMsgView;
+    mMsgActions->printAction()->setEnabled(canPrint);
+    // "Print preview" will act on the visible selection: it will ignore any hidden selection
     if (QAction *printPreviewAction = mMsgActions->printPreviewAction()) {
-        printPreviewAction->setEnabled(singleVisibleMessageSelected && mMsgView);
+        printPreviewAction->setEnabled(canPrint);
     }
 
     // "View Source" will act on the current message: it will ignore any hidden selection
@@ -4106,16 +4181,16 @@ void KMMainWidget::slotIntro()
 
 void KMMainWidget::slotShowStartupFolder()
 {
+    KMail::StartupTraceScope trace("KMMainWidget::slotShowStartupFolder");
     connect(MailCommon::FilterManager::instance(), &FilterManager::filtersChanged,
             this, &KMMainWidget::initializeFilterActions);
     // Plug various action lists. This can't be done in the constructor, as that is called before
     // the main window or Kontact calls createGUI().
     // This function however is called with a single shot timer.
-    checkAkonadiServerManagerState();
-    mFolderShortcutActionManager->createActions();
+    // Filter, folder shortcut and plugin actions are plugged later on, in
+    // slotDelayedInitialization().
     mTagActionManager->createActions();
     messageActions()->setupForwardingActionsList(mGUIClient);
-    initializePluginActions();
 
     const QString newFeaturesMD5 = KMReaderWin::newFeaturesMD5();
     if (kmkernel->firstStart()
@@ -4206,6 +4281,7 @@ void KMMainWidget::clearFilterActions()
 
 void KMMainWidget::initializePluginActions()
 {
+    KMail::StartupTraceScope trace("KMMainWidget::initializePluginActions");
     KMailPluginInterface::self()->initializePluginActions(QStringLiteral("kmail"), mGUIClient);
 }
 
@@ -4231,6 +4307,7 @@ QAction *KMMainWidget::filterToAction(MailCommon::MailFilter *filter)
 //-----------------------------------------------------------------------------
 void KMMainWidget::initializeFilterActions()
 {
+    KMail::StartupTraceScope trace("KMMainWidget::initializeFilterActions");
     clearFilterActions();
     mApplyFilterActionsMenu->menu()->addAction(mApplyAllFiltersAction);
     mApplyFilterFolderActionsMenu->menu()->addAction(mApplyAllFiltersFolderAction);
@@ -4471,36 +4548,106 @@ KMail::FolderShortcutActionManager *KMMainWidget::folderShortcutActionManager()
 
 void KMMainWidget::slotMessageSelected(const Akonadi::Item &item)
 {
+    mSelectionStatsDirty = true;
     delete mShowBusySplashTimer;
     mShowBusySplashTimer = nullptr;
+
+    // Whatever is still on its way to the reader has been superseded by this
+    // selection: drop it before the full payload is transferred.
+    if (mPendingMessageItem.isValid()) {
+        markSkippedMessageAsRead(mPendingMessageItem);
+        mPendingMessageItem = Akonadi::Item();
+    }
+    if (mMessageFetchTimer) {
+        mMessageFetchTimer->stop();
+    }
+    if (mMessageFetchJob) {
+        // Killing a running job makes the shared default session reconnect,
+        // which would disturb every other job queued there: drop its result instead
+        markSkippedMessageAsRead(mMessageFetchJob->property("_item").value<Akonadi::Item>());
+        mMessageFetchJob->setProperty("_superseded", true);
+        mMessageFetchJob = nullptr;
+    }
+
     if (mMsgView) {
         // The current selection was cleared, so we'll remove the previously
         // selected message from the preview pane
         if (!item.isValid()) {
             mMsgView->clear();
+            mLastMessageSelection.invalidate();
         } else {
-            mShowBusySplashTimer = new QTimer(this);
-            mShowBusySplashTimer->setSingleShot(true);
-            connect(mShowBusySplashTimer, &QTimer::timeout, this, &KMMainWidget::slotShowBusySplash);
-            mShowBusySplashTimer->start(1000);
-
-            Akonadi::ItemFetchJob *itemFetchJob = mMsgView->viewer()->createFetchJob(item);
-            if (mCurrentCollection.isValid()) {
-                const QString resource = mCurrentCollection.resource();
-                itemFetchJob->setProperty("_resource", QVariant::fromValue(resource));
-                connect(itemFetchJob, &ItemFetchJob::itemsReceived,
-                        this, &KMMainWidget::itemsReceived);
-                connect(itemFetchJob, &Akonadi::ItemFetchJob::result, this, &KMMainWidget::itemsFetchDone);
+            // While the user keeps navigating (e.g. holding down an arrow key)
+            // only fetch the message they eventually stop on.
+            const bool navigating = mLastMessageSelection.isValid() && mLastMessageSelection.elapsed() < 150;
+            mLastMessageSelection.start();
+            if (navigating) {
+                if (!mMessageFetchTimer) {
+                    mMessageFetchTimer = new QTimer(this);
+                    mMessageFetchTimer->setSingleShot(true);
+                    mMessageFetchTimer->setInterval(150);
+                    connect(mMessageFetchTimer, &QTimer::timeout, this, &KMMainWidget::slotFetchSelectedMessage);
+                }
+                mPendingMessageItem = item;
+                mMessageFetchTimer->start();
+            } else {
+                fetchMessage(item);
             }
         }
     }
 }
 
+void KMMainWidget::slotFetchSelectedMessage()
+{
+    const Akonadi::Item item = mPendingMessageItem;
+    mPendingMessageItem = Akonadi::Item();
+    if (mMsgView && item.isValid()) {
+        fetchMessage(item);
+    }
+}
+
+void KMMainWidget::fetchMessage(const Akonadi::Item &item)
+{
+    delete mShowBusySplashTimer;
+    mShowBusySplashTimer = new QTimer(this);
+    mShowBusySplashTimer->setSingleShot(true);
+    connect(mShowBusySplashTimer, &QTimer::timeout, this, &KMMainWidget::slotShowBusySplash);
+    mShowBusySplashTimer->start(1000);
+
+    Akonadi::ItemFetchJob *itemFetchJob = mMsgView->viewer()->createFetchJob(item);
+    itemFetchJob->setProperty("_item", QVariant::fromValue(item));
+    mMessageFetchJob = itemFetchJob;
+    if (mCurrentCollection.isValid()) {
+        const QString resource = mCurrentCollection.resource();
+        itemFetchJob->setProperty("_resource", QVariant::fromValue(resource));
+        connect(itemFetchJob, &ItemFetchJob::itemsReceived,
+                this, &KMMainWidget::itemsReceived);
+        connect(itemFetchJob, &Akonadi::ItemFetchJob::result, this, &KMMainWidget::itemsFetchDone);
+    }
+}
+
+void KMMainWidget::markSkippedMessageAsRead(Akonadi::Item item)
+{
+    // Messages the user only passed over are not rendered, but mark them as
+    // read anyway if the user settings say so.
+    if (item.isValid()
+        && MessageViewer::MessageViewerSettings::self()->delayedMarkAsRead()
+        && MessageViewer::MessageViewerSettings::self()->delayedMarkTime() == 0) {
+        item.setFlag(Akonadi::MessageFlags::Seen);
+        Akonadi::ItemModifyJob *modifyJob = new Akonadi::ItemModifyJob(item, this);
+        modifyJob->disableRevisionCheck();
+        modifyJob->setIgnorePayload(true);
+    }
+}
+
 void KMMainWidget::itemsReceived(const Akonadi::Item::List &list)
 {
     Q_ASSERT(list.size() == 1);
+    if (sender() && sender()->property("_superseded").toBool()) {
+        return;
+    }
     delete mShowBusySplashTimer;
     mShowBusySplashTimer = nullptr;
+    mMessageFetchJob = nullptr;
 
     if (!mMsgView) {
         return;
@@ -4513,14 +4660,7 @@ void KMMainWidget::itemsReceived(const Akonadi::Item::List &list)
 
         if (mMessagePane->currentItem() != item) {
             // The user has selected another email already, so don't render this one.
-            // Mark it as read, though, if the user settings say so.
-            if (MessageViewer::MessageViewerSettings::self()->delayedMarkAsRead()
-                && MessageViewer::MessageViewerSettings::self()->delayedMarkTime() == 0) {
-                item.setFlag(Akonadi::MessageFlags::Seen);
-                Akonadi::ItemModifyJob *modifyJob = new Akonadi::ItemModifyJob(item, this);
-                modifyJob->disableRevisionCheck();
-                modifyJob->setIgnorePayload(true);
-            }
+            markSkippedMessageAsRead(item);
             return;
         }
     }
@@ -4538,8 +4678,14 @@ void KMMainWidget::itemsReceived(const Akonadi::Item::List &list)
 
 void KMMainWidget::itemsFetchDone(KJob *job)
 {
+    if (job->property("_superseded").toBool()) {
+        return;
+    }
     delete mShowBusySplashTimer;
     mShowBusySplashTimer = nullptr;
+    if (job == mMessageFetchJob) {
+        mMessageFetchJob = nullptr;
+    }
     if (job->error()) {
         // Unfortunately job->error() is Job::Unknown in many cases.
         // (see JobPrivate::handleResponse in akonadi/job.cpp)
@@ -4865,27 +5011,31 @@ void KMMainWidget::setupUnifiedMailboxChecker()
                          KMailSettings::self()->setAskEnableUnifiedMailboxes(false);
 
                          const auto service = Akonadi::ServerManager::self()->agentServiceName(Akonadi::ServerManager::Agent, QStringLiteral("akonadi_unifiedmailbox_agent"));
-                         QDBusInterface iface(service, QStringLiteral("/"), QStringLiteral("org.freedesktop.Akonadi.UnifiedMailboxAgent"),
-                                              QDBusConnection::sessionBus(), this);
-                         if (!iface.isValid()) {
-                             return;
-                         }
-
-                         QDBusReply<bool> reply = iface.call(QStringLiteral("enabledAgent"));
-                         if (!reply.isValid() || bool(reply)) {
-                             return;
-                         }
-
-                         const auto answer = KMessageBox::questionYesNo(
-                             this, i18n("You have more than one email account set up.\nDo you want to enable the Unified Mailbox feature to "
-                                        "show unified content of your inbox, sent and drafts folders?\n"
-                                        "You can configure unified mailboxes, create custom ones or\ndisable the feature completely in KMail's Plugin settings."),
-                             i18n("Enable Unified Mailboxes?"),
-                             KGuiItem(i18n("Enable Unified Mailboxes"), QStringLiteral("dialog-ok")),
-                             KGuiItem(i18n("Cancel"), QStringLiteral("dialog-cancel")));
-                         if (answer == KMessageBox::Yes) {
-                             iface.call(QStringLiteral("setEnableAgent"), true);
-                         }
+                         const QDBusMessage message = QDBusMessage::createMethodCall(service, QStringLiteral("/"), QStringLiteral("org.freedesktop.Akonadi.UnifiedMailboxAgent"),
+                                                                                     QStringLiteral("enabledAgent"));
+                         // Don't block the GUI if the agent doesn't answer
+                         QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(QDBusConnection::sessionBus().asyncCall(message, 5000), this);
+                         connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, service](QDBusPendingCallWatcher *watcher) {
+                             QDBusPendingReply<bool> reply = *watcher;
+                             watcher->deleteLater();
+                             if (reply.isError() || reply.value()) {
+                                 return;
+                             }
+
+                             const auto answer = KMessageBox::questionYesNo(
+                                 this, i18n("You have more than one email account set up.\nDo you want to enable the Unified Mailbox feature to "
+                                            "show unified content of your inbox, sent and drafts folders?\n"
+                                            "You can configure unified mailboxes, create custom ones or\ndisable the feature completely in KMail's Plugin settings."),
+                                 i18n("Enable Unified Mailboxes?"),
+                                 KGuiItem(i18n("Enable Unified Mailboxes"), QStringLiteral("dialog-ok")),
+                                 KGuiItem(i18n("Cancel"), QStringLiteral("dialog-cancel")));
+                             if (answer == KMessageBox::Yes) {
+                                 QDBusMessage enableMessage = QDBusMessage::createMethodCall(service, QStringLiteral("/"), QStringLiteral("org.freedesktop.Akonadi.UnifiedMailboxAgent"),
+                                                                                             QStringLiteral("setEnableAgent"));
+                                 enableMessage << true;
+                                 QDBusConnection::sessionBus().asyncCall(enableMessage);
+                             }
+                         });
                      };
 
     connect(kmkernel, &KMKernel::incomingAccountsChanged, this, ask);
@@ -32,6 +32,7 @@
 #include <kactioncollection.h>
 #include <mailcommon/foldersettings.h>
 
+#include <QElapsedTimer>
 #include <QPointer>
 #include <QTimer>
 #include <Akonadi/KMime/StandardMailActionManager>
@@ -43,6 +44,7 @@ class Transport;
 }
 namespace Akonadi {
 class Tag;
+class ItemFetchJob;
 }
 
 namespace KMime {
@@ -66,6 +68,7 @@ class ManageShowCollectionProperties;
 class KActionMenuTransport;
 class KActionMenuAccount;
 class ZoomLabelWidget;
+class TemplatesFolderIndex;
 
 namespace KIO {
 class Job;
@@ -209,6 +212,7 @@ Q_SIGNALS:
 
 protected:
     void showEvent(QShowEvent *event) override;
+    bool eventFilter(QObject *obj, QEvent *event) override;
 
 private:
     void assignLoadExternalReference();
@@ -396,6 +400,7 @@ private Q_SLOTS:
 
     void slotIntro();
     void slotShowStartupFolder();
+    void slotDelayedInitialization();
     void slotCopyDecryptedTo(QAction *action);
 
     /** Message navigation */
@@ -418,7 +423,7 @@ private Q_SLOTS:
     void slotDisplayCurrentMessage();
 
     void slotShowNewFromTemplate();
-    void slotDelayedShowNewFromTemplate(KJob *);
+    void slotDelayedShowNewFromTemplate();
     void slotNewFromTemplate(QAction *);
 
     /** Update the undo action */
@@ -490,6 +495,7 @@ private Q_SLOTS:
 
     void itemsReceived(const Akonadi::Item::List &list);
     void itemsFetchDone(KJob *job);
+    void slotFetchSelectedMessage();
 
     void slotServerSideSubscription();
     void slotServerStateChanged(Akonadi::ServerManager::State state);
@@ -517,6 +523,16 @@ private:
     void printCurrentMessage(bool preview);
     void replyCurrentMessageCommand(MessageComposer::ReplyStrategy strategy);
     void setupUnifiedMailboxChecker();
+    void fetchMessage(const Akonadi::Item &item);
+
+    struct SelectionStats {
+        int count = 0;
+        int visibleCount = 0;
+        bool allSelectedBelongToSameThread = false;
+        bool hasSelection = false;
+    };
+    const SelectionStats &selectionStats();
+    void markSkippedMessageAsRead(Akonadi::Item item);
     QAction *filterToAction(MailCommon::MailFilter *filter);
     Akonadi::Collection::List applyFilterOnCollection(bool recursive);
     void setShowStatusBarMessage(const QString &msg);
@@ -568,6 +584,7 @@ private:
     QSplitter *mSplitter2 = nullptr;
     QSplitter *mFolderViewSplitter = nullptr;
     Akonadi::Collection mTemplateFolder;
+    TemplatesFolderIndex *mTemplatesFolderIndex = nullptr;
     bool mLongFolderList = false;
     bool mStartupDone = false;
     bool mWasEverShown = false;
@@ -590,12 +607,19 @@ private:
 
     QTimer *menutimer = nullptr;
     QTimer *mShowBusySplashTimer = nullptr;
+    QTimer *mMessageFetchTimer = nullptr;
+    QPointer<Akonadi::ItemFetchJob> mMessageFetchJob;
+    Akonadi::Item mPendingMessageItem;
+    QElapsedTimer mLastMessageSelection;
+    SelectionStats mSelectionStats;
+    bool mSelectionStatsDirty = true;
 
     KSieveUi::VacationManager *mVacationManager = nullptr;
     KActionCollection *mActionCollection = nullptr;
     QAction *mToolbarActionSeparator = nullptr;
     QVBoxLayout *mTopLayout = nullptr;
     bool mDestructed = false;
+    bool mDelayedInitializationDone = false;
     QList<QAction *> mFilterMenuActions;
     QList<QAction *> mFilterFolderMenuActions;
     QList<QAction *> mFilterFolderMenuRecursiveActions;
@@ -657,6 +657,11 @@ void KMReaderWin::setPrinting(bool enable)
     mViewer->setPrinting(enable);
 }
 
+void KMReaderWin::setDeleteAfterPrinting(bool deleteAfterPrinting)
+{
+    mDeleteAfterPrinting = deleteAfterPrinting;
+}
+
 QAction *KMReaderWin::speakTextAction() const
 {
     return mViewer->speakTextAction();
@@ -904,7 +909,8 @@ QList<QAction *> KMReaderWin::interceptorUrlActions(const WebEngineViewer::WebHi
 
 void KMReaderWin::slotPrintingFinished()
 {
-    if (mViewer->printingMode()) {
+    Q_EMIT printingFinished();
+    if (mViewer->printingMode() && mDeleteAfterPrinting) {
         deleteLater();
     }
 }
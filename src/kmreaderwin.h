@@ -71,6 +71,8 @@ public:
     /** Set the override character encoding. */
     void setOverrideEncoding(const QString &encoding);
     void setPrinting(bool enable);
+    /** A printing reader window deletes itself once printing is done, unless it is reused for several print jobs. */
+    void setDeleteAfterPrinting(bool deleteAfterPrinting);
 
     void setMessage(const Akonadi::Item &item, MimeTreeParser::UpdateMode updateMode = MimeTreeParser::Delayed);
 
@@ -185,6 +187,7 @@ Q_SIGNALS:
     void zoomChanged(qreal factor);
     void showPreviousMessage();
     void showNextMessage();
+    void printingFinished();
 
 public Q_SLOTS:
 
@@ -248,6 +251,7 @@ private:
     QMenu *mViewHtmlOptions = nullptr;
 
     MessageViewer::Viewer *mViewer = nullptr;
+    bool mDeleteAfterPrinting = true;
 };
 
 #endif
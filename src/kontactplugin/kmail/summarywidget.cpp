@@ -50,9 +50,15 @@
 #include <QGridLayout>
 #include <QVBoxLayout>
 #include <QItemSelectionModel>
+#include <QTimer>
 
 #include <ctime>
 
+namespace {
+// Statistics can change very often during a sync, don't refresh more often than that
+static const int sUpdateInterval = 100; // ms
+}
+
 SummaryWidget::SummaryWidget(KontactInterface::Plugin *plugin, QWidget *parent)
     : KontactInterface::Summary(parent)
     , mPlugin(plugin)
@@ -90,9 +96,15 @@ SummaryWidget::SummaryWidget(KontactInterface::Plugin *plugin, QWidget *parent)
         = new KViewStateMaintainer<Akonadi::ETMViewStateSaver>(_config->group("CheckState"), this);
     mModelState->setSelectionModel(mSelectionModel);
 
+    mUpdateTimer = new QTimer(this);
+    mUpdateTimer->setSingleShot(true);
+    mUpdateTimer->setInterval(sUpdateInterval);
+    connect(mUpdateTimer, &QTimer::timeout, this, &SummaryWidget::slotUpdateFolderList);
+
     connect(mChangeRecorder, qOverload<const Akonadi::Collection &>(&Akonadi::ChangeRecorder::collectionChanged), this, &SummaryWidget::slotCollectionChanged);
-    connect(mChangeRecorder, &Akonadi::ChangeRecorder::collectionRemoved, this, &SummaryWidget::slotCollectionChanged);
+    connect(mChangeRecorder, &Akonadi::ChangeRecorder::collectionRemoved, this, &SummaryWidget::slotStructureChanged);
     connect(mChangeRecorder, &Akonadi::ChangeRecorder::collectionStatisticsChanged, this, &SummaryWidget::slotCollectionChanged);
+    connect(mModel, &QAbstractItemModel::rowsInserted, this, &SummaryWidget::slotStructureChanged);
     QTimer::singleShot(0, this, &SummaryWidget::slotUpdateFolderList);
 }
 
@@ -103,12 +115,22 @@ int SummaryWidget::summaryHeight() const
 
 void SummaryWidget::slotCollectionChanged()
 {
-    QTimer::singleShot(0, this, &SummaryWidget::slotUpdateFolderList);
+    if (!mUpdateTimer->isActive()) {
+        mUpdateTimer->start();
+    }
+}
+
+void SummaryWidget::slotStructureChanged()
+{
+    mStructureChanged = true;
+    slotCollectionChanged();
 }
 
 void SummaryWidget::updateSummary(bool force)
 {
     Q_UNUSED(force);
+    // Called when the configuration may have changed
+    mConfigChanged = true;
     QTimer::singleShot(0, this, &SummaryWidget::slotUpdateFolderList);
 }
 
@@ -124,7 +146,7 @@ void SummaryWidget::selectFolder(const QString &folder)
     kmail.selectFolder(folder);
 }
 
-void SummaryWidget::displayModel(const QModelIndex &parent, int &counter, const bool showFolderPaths, QStringList parentTreeNames)
+void SummaryWidget::displayModel(const QModelIndex &parent, QVector<FolderEntry> &entries, const bool showFolderPaths, QStringList parentTreeNames)
 {
     const int nbCol = mModelProxy->rowCount(parent);
     for (int i = 0; i < nbCol; ++i) {
@@ -138,86 +160,165 @@ void SummaryWidget::displayModel(const QModelIndex &parent, int &counter, const
         if (col.isValid()) {
             const Akonadi::CollectionStatistics stats = col.statistics();
             if (((stats.unreadCount()) != Q_INT64_C(0)) && showCollection) {
-                // Collection Name.
-                KUrlLabel *urlLabel = nullptr;
-
+                FolderEntry entry;
+                entry.id = col.id();
+                entry.name = col.name();
                 if (showFolderPaths) {
                     // Construct the full path string.
                     parentTreeNames.insert(parentTreeNames.size(), col.name());
-                    urlLabel = new KUrlLabel(QString::number(col.id()),
-                                             parentTreeNames.join(QLatin1Char('/')), this);
+                    entry.displayName = parentTreeNames.join(QLatin1Char('/'));
                     parentTreeNames.removeLast();
                 } else {
-                    urlLabel = new KUrlLabel(QString::number(col.id()), col.name(), this);
+                    entry.displayName = col.name();
                 }
-
-                urlLabel->installEventFilter(this);
-                urlLabel->setAlignment(Qt::AlignLeft);
-                urlLabel->setWordWrap(true);
-                mLayout->addWidget(urlLabel, counter, 1);
-                mLabels.append(urlLabel);
-
-                // tooltip
-                urlLabel->setToolTip(i18n("<qt><b>%1</b>"
-                                          "<br/>Total: %2<br/>"
-                                          "Unread: %3</qt>",
-                                          col.name(),
-                                          stats.count(),
-                                          stats.unreadCount()));
-
-                connect(urlLabel, qOverload<const QString &>(&KUrlLabel::leftClickedUrl), this, &SummaryWidget::selectFolder);
-
-                // Read and unread count.
-                QLabel *label = new QLabel(i18nc("%1: number of unread messages "
-                                                 "%2: total number of messages",
-                                                 "%1 / %2", stats.unreadCount(), stats.count()), this);
-
-                label->setAlignment(Qt::AlignLeft);
-                mLayout->addWidget(label, counter, 2);
-                mLabels.append(label);
-
-                // Folder icon.
-                QIcon icon = mModelProxy->data(child, Qt::DecorationRole).value<QIcon>();
-                label = new QLabel(this);
-                label->setPixmap(icon.pixmap(label->height() / 1.5));
-                label->setMaximumWidth(label->minimumSizeHint().width());
-                label->setAlignment(Qt::AlignVCenter);
-                mLayout->addWidget(label, counter, 0);
-                mLabels.append(label);
-
-                ++counter;
+                entry.unreadCount = stats.unreadCount();
+                entry.count = stats.count();
+                entry.index = child;
+                entries.append(entry);
             }
             parentTreeNames.insert(parentTreeNames.size(), col.name());
-            displayModel(child, counter, showFolderPaths, parentTreeNames);
+            displayModel(child, entries, showFolderPaths, parentTreeNames);
             // Remove the last parent collection name for the next iteration.
             parentTreeNames.removeLast();
         }
     }
 }
 
-void SummaryWidget::slotUpdateFolderList()
+SummaryWidget::FolderRow SummaryWidget::createFolderRow(const FolderEntry &entry)
+{
+    FolderRow row;
+    // Collection Name.
+    row.urlLabel = new KUrlLabel(QString::number(entry.id), entry.displayName, this);
+    row.urlLabel->installEventFilter(this);
+    row.urlLabel->setAlignment(Qt::AlignLeft);
+    row.urlLabel->setWordWrap(true);
+    connect(row.urlLabel, qOverload<const QString &>(&KUrlLabel::leftClickedUrl), this, &SummaryWidget::selectFolder);
+
+    // Read and unread count.
+    row.countLabel = new QLabel(this);
+    row.countLabel->setAlignment(Qt::AlignLeft);
+
+    // Folder icon.
+    const QIcon icon = mModelProxy->data(entry.index, Qt::DecorationRole).value<QIcon>();
+    row.iconLabel = new QLabel(this);
+    row.iconLabel->setPixmap(icon.pixmap(row.iconLabel->height() / 1.5));
+    row.iconLabel->setMaximumWidth(row.iconLabel->minimumSizeHint().width());
+    row.iconLabel->setAlignment(Qt::AlignVCenter);
+
+    row.displayName = entry.displayName;
+    return row;
+}
+
+void SummaryWidget::updateFolderRow(FolderRow &row, const FolderEntry &entry)
+{
+    if (row.displayName != entry.displayName) {
+        row.urlLabel->setText(entry.displayName);
+        row.displayName = entry.displayName;
+    } else if (row.unreadCount == entry.unreadCount && row.count == entry.count) {
+        return;
+    }
+    // tooltip
+    row.urlLabel->setToolTip(i18n("<qt><b>%1</b>"
+                                  "<br/>Total: %2<br/>"
+                                  "Unread: %3</qt>",
+                                  entry.name,
+                                  entry.count,
+                                  entry.unreadCount));
+    row.countLabel->setText(i18nc("%1: number of unread messages "
+                                  "%2: total number of messages",
+                                  "%1 / %2", entry.unreadCount, entry.count));
+    row.unreadCount = entry.unreadCount;
+    row.count = entry.count;
+}
+
+void SummaryWidget::deleteFolderRow(const FolderRow &row)
+{
+    delete row.urlLabel;
+    delete row.countLabel;
+    delete row.iconLabel;
+}
+
+void SummaryWidget::loadConfig()
 {
-    qDeleteAll(mLabels);
-    mLabels.clear();
     mModelState->restoreState();
-    int counter = 0;
-    qCDebug(KMAILPLUGIN_LOG) << QStringLiteral("Iterating over") << mModel->rowCount() << QStringLiteral("collections.");
     KConfig _config(QStringLiteral("kcmkmailsummaryrc"));
     KConfigGroup config(&_config, "General");
     const bool showFolderPaths = config.readEntry("showFolderPaths", false);
-    displayModel(QModelIndex(), counter, showFolderPaths, QStringList());
+    if (showFolderPaths != mShowFolderPaths) {
+        mShowFolderPaths = showFolderPaths;
+        mStructureChanged = true;
+    }
+    mConfigChanged = false;
+}
+
+void SummaryWidget::slotUpdateFolderList()
+{
+    mUpdateTimer->stop();
+    if (mConfigChanged) {
+        loadConfig();
+        // The check states may have changed
+        mStructureChanged = true;
+    } else if (mStructureChanged) {
+        // Apply the check states to new collections
+        mModelState->restoreState();
+    }
+    qCDebug(KMAILPLUGIN_LOG) << QStringLiteral("Iterating over") << mModel->rowCount() << QStringLiteral("collections.");
+    QVector<FolderEntry> entries;
+    displayModel(QModelIndex(), entries, mShowFolderPaths, QStringList());
 
-    if (counter == 0) {
-        QLabel *label = new QLabel(i18n("No unread messages in your monitored folders"), this);
-        label->setAlignment(Qt::AlignHCenter | Qt::AlignVCenter);
-        mLayout->addWidget(label, 0, 0);
-        mLabels.append(label);
+    QVector<Akonadi::Collection::Id> order;
+    order.reserve(entries.count());
+    for (const FolderEntry &entry : qAsConst(entries)) {
+        order.append(entry.id);
     }
 
-    QList<QLabel *>::const_iterator lit;
-    QList<QLabel *>::const_iterator lend(mLabels.constEnd());
-    for (lit = mLabels.constBegin(); lit != lend; ++lit) {
-        (*lit)->show();
+    if (order != mFolderOrder || mStructureChanged) {
+        // Rows appeared, disappeared or moved: reuse the existing labels and lay them out again
+        QHash<Akonadi::Collection::Id, FolderRow> rows;
+        rows.reserve(entries.count());
+        int counter = 0;
+        for (const FolderEntry &entry : qAsConst(entries)) {
+            FolderRow row = mFolderRows.take(entry.id);
+            if (row.urlLabel) {
+                mLayout->removeWidget(row.iconLabel);
+                mLayout->removeWidget(row.urlLabel);
+                mLayout->removeWidget(row.countLabel);
+            } else {
+                row = createFolderRow(entry);
+            }
+            updateFolderRow(row, entry);
+            mLayout->addWidget(row.iconLabel, counter, 0);
+            mLayout->addWidget(row.urlLabel, counter, 1);
+            mLayout->addWidget(row.countLabel, counter, 2);
+            row.iconLabel->show();
+            row.urlLabel->show();
+            row.countLabel->show();
+            rows.insert(entry.id, row);
+            ++counter;
+        }
+        for (const FolderRow &row : qAsConst(mFolderRows)) {
+            deleteFolderRow(row);
+        }
+        mFolderRows = rows;
+        mFolderOrder = order;
+        mStructureChanged = false;
+
+        if (counter == 0) {
+            if (!mNoUnreadLabel) {
+                mNoUnreadLabel = new QLabel(i18n("No unread messages in your monitored folders"), this);
+                mNoUnreadLabel->setAlignment(Qt::AlignHCenter | Qt::AlignVCenter);
+                mLayout->addWidget(mNoUnreadLabel, 0, 0);
+                mNoUnreadLabel->show();
+            }
+        } else if (mNoUnreadLabel) {
+            delete mNoUnreadLabel;
+            mNoUnreadLabel = nullptr;
+        }
+    } else {
+        // Same folders as before, only update the counters which changed
+        for (const FolderEntry &entry : qAsConst(entries)) {
+            updateFolderRow(mFolderRows[entry.id], entry);
+        }
     }
 }
 
@@ -29,10 +29,13 @@
 #include <KontactInterface/Summary>
 
 #include <KViewStateMaintainer>
+#include <AkonadiCore/Collection>
+#include <QHash>
+#include <QModelIndex>
+#include <QVector>
 
 namespace Akonadi {
 class ChangeRecorder;
-class Collection;
 class EntityTreeModel;
 class ETMViewStateSaver;
 }
@@ -46,7 +49,8 @@ class KCheckableProxyModel;
 class QGridLayout;
 class QItemSelectionModel;
 class QLabel;
-class QModelIndex;
+class QTimer;
+class KUrlLabel;
 
 class SummaryWidget : public KontactInterface::Summary
 {
@@ -66,19 +70,47 @@ public Q_SLOTS:
     void updateSummary(bool force) override;
 
 private:
+    struct FolderEntry {
+        Akonadi::Collection::Id id;
+        QString name;
+        QString displayName;
+        qint64 unreadCount;
+        qint64 count;
+        QModelIndex index;
+    };
+    struct FolderRow {
+        KUrlLabel *urlLabel = nullptr;
+        QLabel *countLabel = nullptr;
+        QLabel *iconLabel = nullptr;
+        QString displayName;
+        qint64 unreadCount = -1;
+        qint64 count = -1;
+    };
+
     void selectFolder(const QString &);
     void slotCollectionChanged();
+    void slotStructureChanged();
     void slotUpdateFolderList();
-    void displayModel(const QModelIndex &, int &, const bool, QStringList);
-
-    QList<QLabel *> mLabels;
+    void displayModel(const QModelIndex &, QVector<FolderEntry> &, const bool, QStringList);
+    FolderRow createFolderRow(const FolderEntry &entry);
+    void updateFolderRow(FolderRow &row, const FolderEntry &entry);
+    void deleteFolderRow(const FolderRow &row);
+    void loadConfig();
+
+    QHash<Akonadi::Collection::Id, FolderRow> mFolderRows;
+    QVector<Akonadi::Collection::Id> mFolderOrder;
+    QLabel *mNoUnreadLabel = nullptr;
     QGridLayout *mLayout = nullptr;
+    QTimer *mUpdateTimer = nullptr;
     KontactInterface::Plugin *mPlugin = nullptr;
     Akonadi::ChangeRecorder *mChangeRecorder = nullptr;
     Akonadi::EntityTreeModel *mModel = nullptr;
     KViewStateMaintainer<Akonadi::ETMViewStateSaver> *mModelState = nullptr;
     KCheckableProxyModel *mModelProxy = nullptr;
     QItemSelectionModel *mSelectionModel = nullptr;
+    bool mShowFolderPaths = false;
+    bool mConfigChanged = true;
+    bool mStructureChanged = true;
 };
 
 #endif
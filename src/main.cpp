@@ -31,6 +31,7 @@
 #include "aboutdata.h"
 
 #include "kmstartup.h"
+#include "startuptrace.h"
 
 #include <QDir>
 #include <QApplication>
@@ -142,8 +143,11 @@ int main(int argc, char *argv[])
         return 0;
     }
 
-    KMMigrateApplication migrate;
-    migrate.migrate();
+    {
+        KMail::StartupTraceScope trace("KMMigrateApplication::migrate");
+        KMMigrateApplication migrate;
+        migrate.migrate();
+    }
 
     // import i18n data and icons from libraries:
     KMail::insertLibraryIcons();
@@ -153,16 +157,25 @@ int main(int argc, char *argv[])
     kmailKernel.init();
 
     // and session management
-    kmailKernel.doSessionManagement();
+    {
+        KMail::StartupTraceScope trace("KMKernel::doSessionManagement");
+        kmailKernel.doSessionManagement();
+    }
 
     // any dead letters?
-    kmailKernel.recoverDeadLetters();
+    {
+        KMail::StartupTraceScope trace("KMKernel::recoverDeadLetters");
+        kmailKernel.recoverDeadLetters();
+    }
 
     kmkernel->setupDBus(); // Ok. We are ready for D-Bus requests.
 
     //If the instance hasn't been created yet, do that now
     app.setEventLoopReached();
-    app.delayedInstanceCreation(args, QDir::currentPath());
+    {
+        KMail::StartupTraceScope trace("KMailApplication::delayedInstanceCreation");
+        app.delayedInstanceCreation(args, QDir::currentPath());
+    }
 
     // Go!
     int ret = qApp->exec();
@@ -230,20 +230,20 @@ QAction *MessageActions::editAsNewAction() const
     return mEditAsNewAction;
 }
 
-void MessageActions::setCurrentMessage(const Akonadi::Item &msg, const Akonadi::Item::List &items)
+void MessageActions::setCurrentMessage(const Akonadi::Item &msg, int visibleItemCount)
 {
     mCurrentItem = msg;
 
-    if (!items.isEmpty()) {
+    if (visibleItemCount > 0) {
         if (msg.isValid()) {
-            mVisibleItems = items;
+            mVisibleItemCount = visibleItemCount;
         } else {
-            mVisibleItems.clear();
+            mVisibleItemCount = 0;
         }
     }
 
     if (!msg.isValid()) {
-        mVisibleItems.clear();
+        mVisibleItemCount = 0;
         clearMailingListActions();
     }
 
@@ -323,13 +323,6 @@ void MessageActions::slotItemModified(const Akonadi::Item &item, const QSet< QBy
     Q_UNUSED(partIdentifiers);
     if (item == mCurrentItem) {
         mCurrentItem = item;
-        const int numberOfVisibleItems = mVisibleItems.count();
-        for (int i = 0; i < numberOfVisibleItems; ++i) {
-            Akonadi::Item it = mVisibleItems.at(i);
-            if (item == it) {
-                mVisibleItems[i] = item;
-            }
-        }
         updateActions();
     }
 }
@@ -348,8 +341,8 @@ void MessageActions::updateActions()
         }
     }
 
-    const bool multiVisible = !mVisibleItems.isEmpty() || mCurrentItem.isValid();
-    const bool uniqItem = (itemValid || hasPayload) && (mVisibleItems.count() <= 1);
+    const bool multiVisible = mVisibleItemCount > 0 || mCurrentItem.isValid();
+    const bool uniqItem = (itemValid || hasPayload) && (mVisibleItemCount <= 1);
     mReplyActionMenu->setEnabled(hasPayload);
     mReplyAction->setEnabled(hasPayload);
     mNoQuoteReplyAction->setEnabled(hasPayload);
@@ -603,8 +596,15 @@ void MessageActions::printMessage(bool preview)
             commandInfo.mShowSignatureDetails = mMessageView->viewer()->showSignatureDetails() || MessageViewer::MessageViewerSettings::self()->alwaysShowEncryptionSignatureDetails();
             commandInfo.mShowEncryptionDetails = mMessageView->viewer()->showEncryptionDetails() || MessageViewer::MessageViewerSettings::self()->alwaysShowEncryptionSignatureDetails();
 
-            KMPrintCommand *command
-                = new KMPrintCommand(mParent, commandInfo);
+            // With several visible messages selected in the main window, print all of them
+            Akonadi::Item::List selectedItems;
+            KMMainWidget *mainWidget = qobject_cast<KMMainWidget *>(mParent);
+            if (mainWidget && mVisibleItemCount > 1) {
+                selectedItems = mainWidget->messageListPane()->selectionAsMessageItemList(false);
+            }
+            KMPrintCommand *command = selectedItems.count() > 1
+                                      ? new KMPrintCommand(mParent, selectedItems, commandInfo)
+                                      : new KMPrintCommand(mParent, commandInfo);
             command->start();
         }
     } else {
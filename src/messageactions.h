@@ -69,7 +69,11 @@ public:
      */
     void setupForwardingActionsList(KXMLGUIClient *guiClient);
 
-    void setCurrentMessage(const Akonadi::Item &item, const Akonadi::Item::List &items = Akonadi::Item::List());
+    /**
+     * Sets the message the actions operate on. @p visibleItemCount is the
+     * number of selected and visible messages, 0 keeps the previous count.
+     */
+    void setCurrentMessage(const Akonadi::Item &item, int visibleItemCount = 0);
 
     KActionMenu *replyMenu() const;
     QAction *replyListAction() const;
@@ -144,7 +148,7 @@ private Q_SLOTS:
 private:
     QList<QAction *> mMailListActionList;
     Akonadi::Item mCurrentItem;
-    Akonadi::Item::List mVisibleItems;
+    int mVisibleItemCount = 0;
     QWidget *mParent = nullptr;
     KMReaderWin *mMessageView = nullptr;
 
@@ -0,0 +1,136 @@
+/*
+   Copyright (C) 2026 KDE e.V.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "startuptrace.h"
+#include "kmail_debug.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QVector>
+
+using namespace KMail;
+
+namespace {
+struct TraceEvent {
+    const char *name;
+    qint64 start;
+    qint64 duration; // -1 for instant events
+};
+
+struct TraceData {
+    TraceData()
+    {
+        fileName = qEnvironmentVariable("KMAIL_STARTUP_TRACE");
+        enabled = !fileName.isEmpty();
+        if (enabled) {
+            timer.start();
+        }
+    }
+
+    QString fileName;
+    QElapsedTimer timer;
+    QVector<TraceEvent> events;
+    bool enabled = false;
+};
+
+Q_GLOBAL_STATIC(TraceData, sTraceData)
+}
+
+bool StartupTrace::isEnabled()
+{
+    return sTraceData->enabled;
+}
+
+qint64 StartupTrace::now()
+{
+    return isEnabled() ? sTraceData->timer.nsecsElapsed() / 1000 : 0;
+}
+
+void StartupTrace::addSpan(const char *name, qint64 start, qint64 duration)
+{
+    if (isEnabled()) {
+        sTraceData->events.append({name, start, duration});
+    }
+}
+
+void StartupTrace::addInstant(const char *name)
+{
+    if (isEnabled()) {
+        sTraceData->events.append({name, now(), -1});
+    }
+}
+
+void StartupTrace::finish()
+{
+    if (!isEnabled()) {
+        return;
+    }
+    TraceData *data = sTraceData;
+    data->enabled = false;
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray events;
+    for (const TraceEvent &event : qAsConst(data->events)) {
+        QJsonObject obj;
+        obj.insert(QStringLiteral("name"), QString::fromLatin1(event.name));
+        obj.insert(QStringLiteral("cat"), QStringLiteral("startup"));
+        obj.insert(QStringLiteral("pid"), pid);
+        obj.insert(QStringLiteral("tid"), 1);
+        obj.insert(QStringLiteral("ts"), event.start);
+        if (event.duration < 0) {
+            obj.insert(QStringLiteral("ph"), QStringLiteral("i"));
+            obj.insert(QStringLiteral("s"), QStringLiteral("p"));
+        } else {
+            obj.insert(QStringLiteral("ph"), QStringLiteral("X"));
+            obj.insert(QStringLiteral("dur"), event.duration);
+        }
+        events.append(obj);
+    }
+    data->events.clear();
+
+    QJsonObject root;
+    root.insert(QStringLiteral("traceEvents"), events);
+    root.insert(QStringLiteral("displayTimeUnit"), QStringLiteral("ms"));
+
+    QFile file(data->fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCWarning(KMAIL_LOG) << "Unable to write startup trace to" << data->fileName;
+        return;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    qCDebug(KMAIL_LOG) << "Startup trace written to" << data->fileName;
+}
+
+StartupTraceScope::StartupTraceScope(const char *name)
+    : mName(name)
+{
+    if (StartupTrace::isEnabled()) {
+        mStart = StartupTrace::now();
+    }
+}
+
+StartupTraceScope::~StartupTraceScope()
+{
+    if (mStart >= 0) {
+        StartupTrace::addSpan(mName, mStart, StartupTrace::now() - mStart);
+    }
+}
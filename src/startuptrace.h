@@ -0,0 +1,66 @@
+/*
+   Copyright (C) 2026 KDE e.V.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef STARTUPTRACE_H
+#define STARTUPTRACE_H
+
+#include <QElapsedTimer>
+#include "kmail_export.h"
+
+namespace KMail {
+/**
+ * Records the duration of the startup phases of KMail.
+ *
+ * Tracing is enabled by setting the KMAIL_STARTUP_TRACE environment
+ * variable to the name of a file. The recorded spans are written to that
+ * file in the Chrome trace event format (load it in chrome://tracing or
+ * https://ui.perfetto.dev) once finish() is called.
+ */
+class KMAIL_EXPORT StartupTrace
+{
+public:
+    static bool isEnabled();
+
+    /** Records a span which started at @p start, in microseconds since the trace started. */
+    static void addSpan(const char *name, qint64 start, qint64 duration);
+    /** Records an event without duration. */
+    static void addInstant(const char *name);
+    /** Microseconds since the trace started. */
+    static qint64 now();
+    /** Writes the trace file. Later events are ignored. */
+    static void finish();
+};
+
+/**
+ * Records a span covering the lifetime of the object.
+ */
+class KMAIL_EXPORT StartupTraceScope
+{
+public:
+    explicit StartupTraceScope(const char *name);
+    ~StartupTraceScope();
+
+private:
+    Q_DISABLE_COPY(StartupTraceScope)
+    const char *mName = nullptr;
+    qint64 mStart = -1;
+};
+}
+
+#endif // STARTUPTRACE_H
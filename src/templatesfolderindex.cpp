@@ -0,0 +1,171 @@
+/*
+   Copyright (C) 2026 KDE e.V.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#include "templatesfolderindex.h"
+#include "kmail_debug.h"
+
+#include <AkonadiCore/ItemFetchJob>
+#include <AkonadiCore/ItemFetchScope>
+#include <AkonadiCore/Monitor>
+#include <Akonadi/KMime/MessageParts>
+#include <KMime/Message>
+
+TemplatesFolderIndex::TemplatesFolderIndex(QObject *parent)
+    : QObject(parent)
+{
+}
+
+TemplatesFolderIndex::~TemplatesFolderIndex()
+{
+    if (mFetchJob) {
+        mFetchJob->kill();
+    }
+}
+
+void TemplatesFolderIndex::setCollection(const Akonadi::Collection &collection)
+{
+    if (collection.id() == mCollection.id()) {
+        return;
+    }
+    mCollection = collection;
+    mSubjects.clear();
+    mPendingChanges.clear();
+    mLoaded = false;
+    if (mFetchJob) {
+        mFetchJob->kill();
+        mFetchJob = nullptr;
+    }
+    delete mMonitor;
+    mMonitor = nullptr;
+}
+
+Akonadi::Collection TemplatesFolderIndex::collection() const
+{
+    return mCollection;
+}
+
+bool TemplatesFolderIndex::isLoaded() const
+{
+    return mLoaded;
+}
+
+QMap<Akonadi::Item::Id, QString> TemplatesFolderIndex::subjects() const
+{
+    return mSubjects;
+}
+
+void TemplatesFolderIndex::load()
+{
+    if (mLoaded || mFetchJob || !mCollection.isValid()) {
+        return;
+    }
+
+    // Watch the folder before fetching it, so that no change gets lost
+    // between the fetch and the first notification.
+    if (!mMonitor) {
+        mMonitor = new Akonadi::Monitor(this);
+        mMonitor->setObjectName(QStringLiteral("TemplatesFolderIndexMonitor"));
+        mMonitor->setCollectionMonitored(mCollection);
+        mMonitor->itemFetchScope().fetchPayloadPart(Akonadi::MessagePart::Envelope);
+        connect(mMonitor, &Akonadi::Monitor::itemAdded, this, &TemplatesFolderIndex::slotItemAddedOrChanged);
+        connect(mMonitor, &Akonadi::Monitor::itemChanged, this, &TemplatesFolderIndex::slotItemAddedOrChanged);
+        connect(mMonitor, &Akonadi::Monitor::itemRemoved, this, &TemplatesFolderIndex::slotItemRemoved);
+        connect(mMonitor, &Akonadi::Monitor::itemMoved, this, &TemplatesFolderIndex::slotItemMoved);
+    }
+
+    Akonadi::ItemFetchJob *job = new Akonadi::ItemFetchJob(mCollection, this);
+    job->fetchScope().fetchPayloadPart(Akonadi::MessagePart::Envelope);
+    connect(job, &Akonadi::ItemFetchJob::result, this, &TemplatesFolderIndex::slotFetchDone);
+    mFetchJob = job;
+}
+
+void TemplatesFolderIndex::slotFetchDone(KJob *job)
+{
+    mFetchJob = nullptr;
+    if (job->error()) {
+        qCWarning(KMAIL_LOG) << "Unable to fetch templates" << job->errorString();
+        mPendingChanges.clear();
+        return;
+    }
+    const Akonadi::Item::List items = static_cast<Akonadi::ItemFetchJob *>(job)->items();
+    for (const Akonadi::Item &item : items) {
+        updateItem(item);
+    }
+    // The fetch may or may not include them, so apply them on top of it
+    for (const PendingChange &change : qAsConst(mPendingChanges)) {
+        if (change.removed) {
+            mSubjects.remove(change.item.id());
+        } else {
+            updateItem(change.item);
+        }
+    }
+    mPendingChanges.clear();
+    mLoaded = true;
+    Q_EMIT loaded();
+}
+
+bool TemplatesFolderIndex::updateItem(const Akonadi::Item &item)
+{
+    if (!item.hasPayload<KMime::Message::Ptr>()) {
+        return false;
+    }
+    const KMime::Message::Ptr msg = item.payload<KMime::Message::Ptr>();
+    const QString subject = msg->subject()->asUnicodeString();
+    auto it = mSubjects.find(item.id());
+    if (it != mSubjects.end() && it.value() == subject) {
+        return false;
+    }
+    mSubjects.insert(item.id(), subject);
+    return true;
+}
+
+void TemplatesFolderIndex::slotItemAddedOrChanged(const Akonadi::Item &item)
+{
+    if (!mLoaded) {
+        if (mFetchJob) {
+            mPendingChanges.append({item, false});
+        }
+        return;
+    }
+    if (updateItem(item)) {
+        Q_EMIT changed();
+    }
+}
+
+void TemplatesFolderIndex::slotItemRemoved(const Akonadi::Item &item)
+{
+    if (!mLoaded) {
+        if (mFetchJob) {
+            mPendingChanges.append({item, true});
+        }
+        return;
+    }
+    if (mSubjects.remove(item.id()) > 0) {
+        Q_EMIT changed();
+    }
+}
+
+void TemplatesFolderIndex::slotItemMoved(const Akonadi::Item &item, const Akonadi::Collection &source, const Akonadi::Collection &destination)
+{
+    if (destination.id() == mCollection.id()) {
+        slotItemAddedOrChanged(item);
+    } else if (source.id() == mCollection.id()) {
+        slotItemRemoved(item);
+    }
+}
@@ -0,0 +1,87 @@
+/*
+   Copyright (C) 2026 KDE e.V.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Library General Public
+   License as published by the Free Software Foundation; either
+   version 2 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Library General Public License for more details.
+
+   You should have received a copy of the GNU Library General Public License
+   along with this library; see the file COPYING.LIB.  If not, write to
+   the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+   Boston, MA 02110-1301, USA.
+*/
+
+#ifndef TEMPLATESFOLDERINDEX_H
+#define TEMPLATESFOLDERINDEX_H
+
+#include <QObject>
+#include <QMap>
+#include <QVector>
+#include <AkonadiCore/Collection>
+#include <AkonadiCore/Item>
+#include "kmail_export.h"
+
+class KJob;
+namespace Akonadi {
+class Monitor;
+}
+/**
+ * Keeps the subjects of the messages of a templates folder.
+ *
+ * The index is filled with an envelope-only fetch and kept up to date
+ * through a monitor, so that the "New Message From Template" menu can be
+ * shown without downloading the templates themselves.
+ */
+class KMAIL_EXPORT TemplatesFolderIndex : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TemplatesFolderIndex(QObject *parent = nullptr);
+    ~TemplatesFolderIndex();
+
+    void setCollection(const Akonadi::Collection &collection);
+    Akonadi::Collection collection() const;
+
+    /**
+     * Starts filling the index if it was not filled yet.
+     * loaded() is emitted once the subjects are available.
+     */
+    void load();
+    bool isLoaded() const;
+
+    /** Subjects of the templates, ordered by item id. */
+    QMap<Akonadi::Item::Id, QString> subjects() const;
+
+Q_SIGNALS:
+    void loaded();
+    void changed();
+
+private:
+    Q_DISABLE_COPY(TemplatesFolderIndex)
+    void slotFetchDone(KJob *job);
+    void slotItemAddedOrChanged(const Akonadi::Item &item);
+    void slotItemRemoved(const Akonadi::Item &item);
+    void slotItemMoved(const Akonadi::Item &item, const Akonadi::Collection &source, const Akonadi::Collection &destination);
+    bool updateItem(const Akonadi::Item &item);
+
+    struct PendingChange {
+        Akonadi::Item item;
+        bool removed;
+    };
+
+    QMap<Akonadi::Item::Id, QString> mSubjects;
+    // Notifications received while the index is being filled
+    QVector<PendingChange> mPendingChanges;
+    Akonadi::Collection mCollection;
+    Akonadi::Monitor *mMonitor = nullptr;
+    KJob *mFetchJob = nullptr;
+    bool mLoaded = false;
+};
+
+#endif // TEMPLATESFOLDERINDEX_H